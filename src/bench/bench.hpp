@@ -0,0 +1,62 @@
+#ifndef __BENCH_HPP
+#define __BENCH_HPP
+
+#include <chrono>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <Histogram.hpp>
+
+/***
+ * Helpers shared by the benchmarks. Every run of a case is timed with the
+ * steady clock and recorded in nsec into a Histogram, the first runs warm
+ * caches and allocations up and are not recorded.
+ */
+namespace bench {
+
+    /***
+     * time a single call
+     * @param f
+     * @return time in nsec
+     */
+    template <typename F>
+    inline uint64_t time(F &&f) {
+        const auto begin = std::chrono::steady_clock::now();
+        f();
+        return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin).count();
+    }
+
+    /***
+     * run a case repeatedly
+     * @param f
+     * @param runs number of recorded runs
+     * @param warmup number of runs before recording
+     * @return times of the recorded runs in nsec
+     */
+    template <typename F>
+    inline Histogram::Snapshot run(F &&f, unsigned int runs, unsigned int warmup=10) {
+        for (unsigned int i = 0; i < warmup; ++i) {
+            f();
+        }
+        Histogram histogram;
+        for (unsigned int i = 0; i < runs; ++i) {
+            histogram.record(time(f));
+        }
+        return histogram.snapshot();
+    }
+
+    /***
+     * print mean, median, 99th percentile and maximum of a case in usec
+     * @param name
+     * @param times in nsec
+     */
+    inline void report(const std::string &name, const Histogram::Snapshot &times) {
+        std::printf("%-32s mean=%10.2fus p50=%10.2fus p99=%10.2fus max=%10.2fus\n", name.c_str(),
+                    times.mean() / 1000.0, times.percentile(0.5) / 1000.0, times.percentile(0.99) / 1000.0,
+                    times.max / 1000.0);
+    }
+
+}
+
+#endif // __BENCH_HPP
@@ -0,0 +1,212 @@
+#include <VideoCodec.hpp>
+#include <QualityController.hpp>
+#include <Histogram.hpp>
+#include <bench.hpp>
+#include <footage.hpp>
+#include <opencv2/core.hpp>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+// frame rate the bitrate is given for, that of the camera
+static const double FRAME_RATE = 30.0;
+
+/***
+ * stream the frames through an encoder and a decoder like host and monitor do
+ * @param name
+ * @param encoder
+ * @param codec
+ * @param frames
+ * @return false if a frame has been held back by the encoder or could not be decoded
+ */
+static bool stream(const std::string &name, VideoEncoder &encoder, VideoEncoder::codec_t codec,
+                   const std::vector<cv::Mat> &frames) {
+    std::unique_ptr<VideoDecoder> decoder = VideoDecoder::create(codec);
+    Histogram encode_times, decode_times;
+    std::vector<unsigned char> buffer;
+    cv::Mat decoded;
+    size_t bytes = 0, keyframes = 0, keyframe_bytes = 0;
+    double psnr = 0.0;
+    bool ok = true;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        encode_times.record(bench::time([&] { encoder.encode(frames[i], buffer); }));
+        if (buffer.empty()) {
+            std::printf("  frame %zu has been held back by the encoder\n", i);
+            ok = false;
+            continue;
+        }
+        bytes += buffer.size();
+        if (encoder.keyframe()) {
+            keyframes += 1;
+            keyframe_bytes += buffer.size();
+        }
+
+        bool decodable = false;
+        decode_times.record(bench::time([&] { decodable = decoder->decode(buffer, decoded); }));
+        if (!decodable) {
+            std::printf("  frame %zu cannot be decoded\n", i);
+            ok = false;
+            continue;
+        }
+        // VP8 cuts odd rows and columns off
+        psnr += cv::PSNR(frames[i](cv::Rect(0, 0, decoded.cols, decoded.rows)), decoded);
+    }
+
+    const double per_frame = double(bytes) / double(frames.size());
+    std::printf("  %-24s %8.0f bytes/frame %8.0f kbit/s at %.0f fps PSNR=%5.1fdB keyframes=%zu (%.0f bytes)\n",
+                name.c_str(), per_frame, per_frame * 8.0 * FRAME_RATE / 1000.0, FRAME_RATE,
+                psnr / double(frames.size()), keyframes, keyframes > 0 ? double(keyframe_bytes) / keyframes : 0.0);
+    bench::report("    encode", encode_times.snapshot());
+    bench::report("    decode", decode_times.snapshot());
+    return ok;
+}
+
+/***
+ * a keyframe requested in the middle of the stream, like for a client that joins,
+ * must be the next frame and a new decoder must be able to start with it
+ * @param encoder
+ * @param codec
+ * @param frames
+ * @return
+ */
+static bool keyframe_on_demand(VideoEncoder &encoder, VideoEncoder::codec_t codec, const std::vector<cv::Mat> &frames) {
+    std::vector<unsigned char> buffer;
+    const size_t middle = frames.size() / 2;
+    for (size_t i = 0; i < middle; ++i) {
+        encoder.encode(frames[i], buffer);
+    }
+    encoder.requestKeyframe();
+    encoder.encode(frames[middle], buffer);
+    std::unique_ptr<VideoDecoder> joined = VideoDecoder::create(codec);
+    cv::Mat decoded;
+    if (!encoder.keyframe() || !joined->decode(buffer, decoded)) {
+        std::printf("  requested keyframe has not been produced or cannot be decoded\n");
+        return false;
+    }
+    for (size_t i = middle + 1; i < frames.size(); ++i) {
+        encoder.encode(frames[i], buffer);
+        if (!joined->decode(buffer, decoded)) {
+            std::printf("  frame %zu after the keyframe cannot be decoded\n", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+/***
+ * a frame of the stream is lost like a datagram over UDP, the receiver resets its
+ * decoder and requests a keyframe, the frames decoded from the keyframe on must be
+ * as good as those of a receiver that has lost nothing, a decoder that is not reset
+ * is shown for comparison
+ * @param bitrate
+ * @param frames
+ * @return false if more than one frame is skipped or the quality has not recovered
+ */
+static bool recover_from_loss(unsigned int bitrate, const std::vector<cv::Mat> &frames) {
+    QualityController unused;
+    const auto encoder = VideoEncoder::create(VideoEncoder::VP8, unused, bitrate);
+    const auto lossless = VideoDecoder::create(VideoEncoder::VP8);
+    const auto receiver = VideoDecoder::create(VideoEncoder::VP8);
+    const auto drifting = VideoDecoder::create(VideoEncoder::VP8);
+    const size_t lost = frames.size() / 3;
+    std::vector<unsigned char> buffer;
+    cv::Mat decoded;
+    // PSNR of the frames the receiver has decoded after the loss, summed up for every decoder
+    double reference = 0.0, recovered = 0.0, drift = 0.0;
+    size_t n = 0, skipped = 0, drifted = 0;
+    const auto psnr = [&](size_t i) {
+        return cv::PSNR(frames[i](cv::Rect(0, 0, decoded.cols, decoded.rows)), decoded);
+    };
+    for (size_t i = 0; i < frames.size(); ++i) {
+        encoder->encode(frames[i], buffer);
+        const bool complete = lossless->decode(buffer, decoded);
+        const double lossless_psnr = complete ? psnr(i) : 0.0;
+        if (i == lost) {
+            // the receiver notices the loss with the next frame, as UdpReceiver does
+            receiver->reset();
+            continue;
+        }
+        if (drifting->decode(buffer, decoded) && i > lost) {
+            drift += psnr(i);
+            drifted += 1;
+        }
+        if (!receiver->decode(buffer, decoded)) {
+            // the request reaches the encoder before the next frame, as the hello of UdpReceiver does
+            encoder->requestKeyframe();
+            skipped += 1;
+            continue;
+        }
+        if (i > lost) {
+            reference += lossless_psnr;
+            recovered += psnr(i);
+            n += 1;
+        }
+    }
+
+    std::printf("  VP8 %ukbit/s frame %zu lost: skipped=%zu PSNR after recovery=%5.1fdB lossless=%5.1fdB"
+                " without reset=%5.1fdB\n", bitrate, lost, skipped, n > 0 ? recovered / n : 0.0,
+                n > 0 ? reference / n : 0.0, drifted > 0 ? drift / drifted : 0.0);
+    // only the frame after the lost one is skipped, the next one is the keyframe
+    if (skipped != 1 || n == 0) {
+        std::printf("  receiver has not resumed with the requested keyframe\n");
+        return false;
+    }
+    // a keyframe at the same bitrate is coarser for a few frames
+    if (recovered / n < reference / n - 3.0) {
+        std::printf("  quality has not recovered after the loss\n");
+        return false;
+    }
+    return true;
+}
+
+/***
+ * Streams recorded or synthetic footage through the JPEG path and through VP8
+ * at several bitrates. Reports the size of the frames and the bitrate they make
+ * up, the quality as PSNR and the encode and decode latency per frame. Fails if
+ * an encoder holds a frame back, a frame cannot be decoded, a keyframe
+ * requested in the middle of the stream does not come with the next frame or
+ * the quality does not recover after a frame has been lost.
+ * usage: codec_bench [frames] [recording]
+ */
+int main(int argc, const char *argv[]) {
+    const auto count = (size_t) (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 150);
+
+    std::vector<std::vector<cv::Mat>> scenes;
+    if (argc > 2) {
+        scenes.push_back(footage::load(argv[2], count));
+    } else {
+        // the camera resolutions rchost is usually run with
+        for (const cv::Size size : { cv::Size(320, 240), cv::Size(640, 480) }) {
+            scenes.push_back(footage::synthesize(size, count));
+        }
+    }
+
+    bool ok = true;
+    for (const auto &frames : scenes) {
+        std::printf("%dx%d frames=%zu\n", frames[0].cols, frames[0].rows, frames.size());
+
+        // without a target latency JPEG is encoded at the maximum quality of the range
+        for (const int quality : { 50, 80 }) {
+            QualityController controller;
+            controller.setQualityRange(quality, quality);
+            const auto encoder = VideoEncoder::create(VideoEncoder::JPEG, controller);
+            ok &= stream("JPEG quality=" + std::to_string(quality), *encoder, VideoEncoder::JPEG, frames);
+        }
+
+        if (!VideoEncoder::available(VideoEncoder::VP8)) {
+            std::printf("  VP8 not available, built without libvpx\n");
+            continue;
+        }
+        QualityController unused;
+        for (const unsigned int bitrate : { 250u, 500u, 1000u, 2000u }) {
+            const auto encoder = VideoEncoder::create(VideoEncoder::VP8, unused, bitrate);
+            ok &= stream("VP8 " + std::to_string(bitrate) + "kbit/s", *encoder, VideoEncoder::VP8, frames);
+        }
+        const auto encoder = VideoEncoder::create(VideoEncoder::VP8, unused, 1000);
+        ok &= keyframe_on_demand(*encoder, VideoEncoder::VP8, frames);
+        ok &= recover_from_loss(1000, frames);
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,83 @@
+#ifndef __FOOTAGE_HPP
+#define __FOOTAGE_HPP
+
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+/***
+ * Frames the video benchmarks encode. Recorded footage is read from a video
+ * file, without one a scene like the car's camera sees it on the bench is
+ * synthesized: a static textured background with sensor noise and an object
+ * moving across it.
+ */
+namespace footage {
+
+    /***
+     * read the frames of a recording
+     * @param path video file or image sequence cv::VideoCapture can open
+     * @param frames maximum number of frames to read
+     * @return BGR frames
+     */
+    inline std::vector<cv::Mat> load(const std::string &path, size_t frames) {
+        cv::VideoCapture capture(path);
+        if (!capture.isOpened()) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        std::vector<cv::Mat> result;
+        cv::Mat frame;
+        while (result.size() < frames && capture.read(frame) && !frame.empty()) {
+            result.push_back(frame.clone());
+        }
+        if (result.empty()) {
+            throw std::runtime_error(path + " contains no frames");
+        }
+        return result;
+    }
+
+    /***
+     * synthesize a mostly static scene
+     * @param size
+     * @param frames number of frames
+     * @param seed
+     * @return BGR frames
+     */
+    inline std::vector<cv::Mat> synthesize(const cv::Size &size, size_t frames, unsigned int seed=42) {
+        std::mt19937 rng(seed);
+        cv::Mat background(size, CV_8UC3);
+        for (int y = 0; y < size.height; ++y) {
+            unsigned char *row = background.ptr<unsigned char>(y);
+            for (int x = 0; x < size.width; ++x) {
+                // smooth gradients with some texture, like walls and floor
+                row[3 * x] = (unsigned char) ((x * 255) / size.width);
+                row[3 * x + 1] = (unsigned char) ((y * 255) / size.height);
+                row[3 * x + 2] = (unsigned char) (((x / 16 + y / 16) % 2) * 64 + 96);
+            }
+        }
+
+        std::vector<cv::Mat> result;
+        std::uniform_int_distribution<int> noise(-4, 4);
+        const int object = size.height / 4;
+        for (size_t i = 0; i < frames; ++i) {
+            cv::Mat frame = background.clone();
+            const int x = (int) ((i * 8) % (size_t) std::max(1, size.width - object));
+            cv::rectangle(frame, cv::Rect(x, size.height / 2 - object / 2, object, object), cv::Scalar(40, 40, 200), -1);
+            for (int y = 0; y < size.height; ++y) {
+                unsigned char *row = frame.ptr<unsigned char>(y);
+                for (int j = 0; j < 3 * size.width; ++j) {
+                    row[j] = cv::saturate_cast<unsigned char>(row[j] + noise(rng));
+                }
+            }
+            result.push_back(frame);
+        }
+        return result;
+    }
+
+}
+
+#endif // __FOOTAGE_HPP
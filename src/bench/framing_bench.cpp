@@ -0,0 +1,95 @@
+#include <Framing.hpp>
+#include <bench.hpp>
+#include <boost/asio.hpp>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <netinet/in.h>
+
+using boost::asio::ip::tcp;
+
+// reads length prefixed frames and answers each one with a single byte until the peer closes
+static void echo(tcp::socket socket) {
+    std::vector<unsigned char> payload;
+    boost::system::error_code error;
+    for (;;) {
+        uint32_t header;
+        boost::asio::read(socket, boost::asio::buffer(&header, sizeof(header)), error);
+        if (error) {
+            return;
+        }
+        payload.resize(ntohl(header));
+        boost::asio::read(socket, boost::asio::buffer(payload), error);
+        if (error) {
+            return;
+        }
+        const unsigned char ack = 1;
+        boost::asio::write(socket, boost::asio::buffer(&ack, 1), error);
+        if (error) {
+            return;
+        }
+    }
+}
+
+/***
+ * Sends frames over a loopback TCP connection, once as a header and a payload
+ * written one after another like before the framing layer and once as a single
+ * gather write, under each socket policy. The receiver acknowledges every frame
+ * with one byte, the time until the acknowledgement arrives is the per-frame latency.
+ * usage: framing_bench [runs]
+ */
+int main(int argc, const char *argv[]) {
+    const unsigned int runs = argc > 1 ? (unsigned int) std::strtoul(argv[1], nullptr, 10) : 200;
+
+    boost::asio::io_service io_service;
+    tcp::acceptor acceptor(io_service, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    const tcp::endpoint endpoint = acceptor.local_endpoint();
+
+    // typical sizes of a JPEG frame at 320x240, 640x480 and 1280x720
+    for (const size_t size : { 8 * 1024, 40 * 1024, 120 * 1024 }) {
+        std::vector<unsigned char> payload(size, 0x55);
+        std::printf("frame=%zuKiB\n", size / 1024);
+
+        const framing::policy_t policies[] = { framing::NAGLE, framing::NODELAY, framing::CORK };
+        const char *names[] = { "NAGLE", "NODELAY", "CORK" };
+        for (size_t p = 0; p < 3; ++p) {
+            for (const bool gather : { false, true }) {
+                // the old path had no corking, it is only measured with the gather write
+                if (!gather && policies[p] == framing::CORK) {
+                    continue;
+                }
+
+                tcp::socket socket(io_service);
+                socket.connect(endpoint);
+                std::thread receiver(echo, acceptor.accept());
+                framing::set_policy(socket, policies[p]);
+
+                framing::Message message;
+                message.add(payload);
+                const uint32_t header = htonl((uint32_t) size);
+                boost::system::error_code error;
+                const auto times = bench::run([&] {
+                    if (gather) {
+                        framing::write(socket, message, policies[p], error);
+                    } else {
+                        boost::asio::write(socket, boost::asio::buffer(&header, sizeof(header)), error);
+                        boost::asio::write(socket, boost::asio::buffer(payload), error);
+                    }
+                    unsigned char ack;
+                    boost::asio::read(socket, boost::asio::buffer(&ack, 1), error);
+                }, runs);
+
+                socket.close();
+                receiver.join();
+                if (error) {
+                    std::printf("  %s: %s\n", names[p], error.message().c_str());
+                    return EXIT_FAILURE;
+                }
+                bench::report(std::string("  ") + names[p] + (gather ? " gather write" : " two writes"), times);
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include <ParallelJpeg.hpp>
+#include <VideoCodec.hpp>
+#include <bench.hpp>
+#include <footage.hpp>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+/***
+ * Compresses frames with cv::imencode and with ParallelJpegEncoder split into
+ * 1, 2, 4 and one strip per thread of OpenCV's pool and reports the time per
+ * frame. The frames of every strip count must be the very bitstream of a
+ * single strip and decode with the JpegDecoder of VideoReceiver.
+ * usage: jpeg_bench [runs] [recording]
+ */
+int main(int argc, const char *argv[]) {
+    const unsigned int runs = argc > 1 ? (unsigned int) std::strtoul(argv[1], nullptr, 10) : 50;
+    const int quality = 80;
+    const size_t frames = 30;
+
+    std::vector<std::vector<cv::Mat>> scenes;
+    if (argc > 2) {
+        scenes.push_back(footage::load(argv[2], frames));
+    } else {
+        for (const cv::Size size : { cv::Size(640, 480), cv::Size(1280, 720), cv::Size(1920, 1080) }) {
+            scenes.push_back(footage::synthesize(size, frames));
+        }
+    }
+
+    const unsigned int threads = (unsigned int) std::max(1, cv::getNumThreads());
+    std::vector<unsigned int> strip_counts = { 1, 2, 4 };
+    if (threads > 4) {
+        strip_counts.push_back(threads);
+    }
+
+    JpegDecoder decoder;
+    bool ok = true;
+    for (const auto &scene : scenes) {
+        std::printf("%dx%d quality=%d threads=%u\n", scene[0].cols, scene[0].rows, quality, threads);
+        const std::vector<int> params = { cv::IMWRITE_JPEG_QUALITY, quality };
+        std::vector<unsigned char> buffer;
+        size_t i = 0;
+        const auto imencode = bench::run([&] {
+            cv::imencode(".jpeg", scene[i++ % scene.size()], buffer, params);
+        }, runs);
+        bench::report("  cv::imencode", imencode);
+
+        // bitstreams of a single strip, every strip count has to produce them as well
+        std::vector<std::vector<unsigned char>> reference(scene.size());
+        ParallelJpegEncoder single(1);
+        for (size_t j = 0; j < scene.size(); ++j) {
+            single.encode(scene[j], quality, reference[j]);
+        }
+
+        double one_strip = 0.0;
+        for (const unsigned int strips : strip_counts) {
+            ParallelJpegEncoder encoder(strips);
+            i = 0;
+            const auto times = bench::run([&] {
+                encoder.encode(scene[i++ % scene.size()], quality, buffer);
+            }, runs);
+            if (strips == 1) {
+                one_strip = times.mean();
+            }
+            bench::report("  ParallelJpegEncoder strips=" + std::to_string(strips), times);
+            std::printf("  speedup=%.1fx over 1 strip, %.1fx over cv::imencode\n", one_strip / times.mean(),
+                        imencode.mean() / times.mean());
+
+            for (size_t j = 0; j < scene.size(); ++j) {
+                encoder.encode(scene[j], quality, buffer);
+                if (buffer != reference[j]) {
+                    std::printf("  frame %zu differs from the single strip bitstream\n", j);
+                    ok = false;
+                    break;
+                }
+                cv::Mat decoded;
+                if (!decoder.decode(buffer, decoded) || decoded.rows != scene[j].rows
+                    || decoded.cols != scene[j].cols) {
+                    std::printf("  frame %zu does not decode\n", j);
+                    ok = false;
+                    break;
+                }
+            }
+        }
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,107 @@
+#include <NMS.hpp>
+#include <Candidates.hpp>
+#include <bench.hpp>
+#include <opencv2/core.hpp>
+#include <opencv2/dnn.hpp>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+/***
+ * create candidates like a detector produces them, every object is hit by a
+ * cluster of boxes of the same class that overlap each other
+ * @param n number of candidates
+ * @param classes
+ * @param rng
+ * @return
+ */
+static Candidates synthesize(size_t n, int classes, std::mt19937 &rng) {
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::normal_distribution<float> jitter(0.0f, 4.0f);
+    Candidates candidates;
+    candidates.reserve(n);
+    while (candidates.size() < n) {
+        const float x = 600.0f * uniform(rng);
+        const float y = 440.0f * uniform(rng);
+        const float w = 20.0f + 100.0f * uniform(rng);
+        const float h = 20.0f + 100.0f * uniform(rng);
+        const int id = (int) (rng() % classes);
+        const size_t boxes = std::min<size_t>(5 + rng() % 20, n - candidates.size());
+        for (size_t i = 0; i < boxes; ++i) {
+            const float x1 = x + jitter(rng);
+            const float y1 = y + jitter(rng);
+            candidates.push_back(x1, y1, x1 + w + jitter(rng), y1 + h + jitter(rng), 0.3f + 0.7f * uniform(rng), id);
+        }
+    }
+    return candidates;
+}
+
+/***
+ * Suppresses synthetic detection candidates with NMS and with cv::dnn::NMSBoxes.
+ * NMSBoxes mixes classes, so every class is moved to its own region of the plane
+ * to make it suppress per class as well, both have to keep the same boxes.
+ * Top-K and soft-NMS are timed on their own.
+ * usage: nms_bench [runs]
+ */
+int main(int argc, const char *argv[]) {
+    const unsigned int runs = argc > 1 ? (unsigned int) std::strtoul(argv[1], nullptr, 10) : 200;
+    const float score_threshold = 0.5f;
+    const float iou_threshold = 0.4f;
+    const int classes = 80;
+    std::mt19937 rng(42);
+
+    bool ok = true;
+    for (const size_t n : { 100, 1000, 5000 }) {
+        Candidates candidates = synthesize(n, classes, rng);
+
+        // boxes of different classes never overlap once they are moved apart
+        std::vector<cv::Rect2d> boxes(n);
+        for (size_t i = 0; i < n; ++i) {
+            const double offset = candidates.class_id[i] * 10000.0;
+            boxes[i] = cv::Rect2d(candidates.x1[i] + offset, candidates.y1[i], candidates.x2[i] - candidates.x1[i],
+                                  candidates.y2[i] - candidates.y1[i]);
+        }
+
+        NMS nms;
+        nms.setIoUThreshold(iou_threshold);
+        nms.setScoreThreshold(score_threshold);
+        std::vector<int> kept, reference;
+        const auto hard = bench::run([&] { nms.run(candidates, kept); }, runs);
+        const auto nmsboxes = bench::run([&] {
+            cv::dnn::NMSBoxes(boxes, candidates.score, score_threshold, iou_threshold, reference);
+        }, runs);
+
+        nms.setTopK(20);
+        std::vector<int> top;
+        const auto top_k = bench::run([&] { nms.run(candidates, top); }, runs);
+
+        // soft-NMS lowers the scores in place, every run starts from a copy of the original ones
+        // and the copy is part of the time
+        nms.setTopK(0);
+        nms.setSoftSigma(0.5f);
+        Candidates decayed;
+        std::vector<int> soft;
+        const auto soft_nms = bench::run([&] {
+            decayed = candidates;
+            nms.run(decayed, soft);
+        }, runs);
+
+        std::printf("candidates=%zu kept=%zu\n", n, kept.size());
+        bench::report("  NMS", hard);
+        bench::report("  cv::dnn::NMSBoxes", nmsboxes);
+        std::printf("  speedup=%.1fx\n", nmsboxes.mean() / hard.mean());
+        bench::report("  NMS top-K=20", top_k);
+        bench::report("  NMS soft sigma=0.5", soft_nms);
+
+        std::sort(kept.begin(), kept.end());
+        std::sort(reference.begin(), reference.end());
+        if (kept != reference) {
+            std::printf("  kept boxes differ, NMSBoxes kept %zu\n", reference.size());
+            ok = false;
+        }
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,116 @@
+#include <RegionDecoder.hpp>
+#include <Candidates.hpp>
+#include <bench.hpp>
+#include <opencv2/core.hpp>
+#include <random>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+// decoding as done before RegionDecoder, every row is searched with cv::minMaxLoc
+static void decodeMinMaxLoc(const cv::Mat &out, const cv::Size &size, float threshold, Candidates &candidates) {
+    for (int j = 0; j < out.rows; ++j) {
+        const float *row = out.ptr<float>(j);
+        cv::Mat scores = out.row(j).colRange(5, out.cols);
+        cv::Point id;
+        double confidence;
+        cv::minMaxLoc(scores, nullptr, &confidence, nullptr, &id);
+        if (confidence > threshold) {
+            const float half_width = row[2] * 0.5f;
+            const float half_height = row[3] * 0.5f;
+            candidates.push_back((row[0] - half_width) * size.width, (row[1] - half_height) * size.height,
+                                 (row[0] + half_width) * size.width, (row[1] + half_height) * size.height,
+                                 (float) confidence, id.x);
+        }
+    }
+}
+
+/***
+ * create the output of a Region layer, like a real one most rows have a low objectness
+ * and the class scores are scaled by the objectness
+ * @param rows number of candidate boxes
+ * @param classes
+ * @param objects fraction of rows that contain an object
+ * @param rng
+ * @return
+ */
+static cv::Mat synthesize(int rows, int classes, double objects, std::mt19937 &rng) {
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::bernoulli_distribution object(objects);
+    cv::Mat out(rows, classes + 5, CV_32F);
+    for (int j = 0; j < rows; ++j) {
+        float *row = out.ptr<float>(j);
+        row[0] = uniform(rng);
+        row[1] = uniform(rng);
+        row[2] = 0.05f + 0.3f * uniform(rng);
+        row[3] = 0.05f + 0.3f * uniform(rng);
+        row[4] = object(rng) ? 0.5f + 0.5f * uniform(rng) : 0.1f * uniform(rng);
+        for (int c = 0; c < classes; ++c) {
+            row[5 + c] = row[4] * uniform(rng) * uniform(rng);
+        }
+        // one class dominates an object
+        row[5 + rng() % classes] = row[4] * (0.8f + 0.2f * uniform(rng));
+    }
+    return out;
+}
+
+static bool same(const Candidates &a, const Candidates &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a.class_id[i] != b.class_id[i] || a.score[i] != b.score[i] || a.x1[i] != b.x1[i] || a.y2[i] != b.y2[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/***
+ * Decodes synthetic YOLO Region output blobs with RegionDecoder and with the
+ * per-row cv::minMaxLoc search it replaced, checks that both find the same
+ * candidates and reports the time per blob.
+ * usage: region_bench [runs]
+ */
+int main(int argc, const char *argv[]) {
+    const unsigned int runs = argc > 1 ? (unsigned int) std::strtoul(argv[1], nullptr, 10) : 200;
+    const float threshold = 0.5f;
+    const int classes = 80;
+    std::mt19937 rng(42);
+
+    // candidate rows of yolov3-tiny, 3 anchors on a 1/32 and a 1/16 grid
+    const int inputs[] = { 320, 416, 608 };
+    bool ok = true;
+    for (const int input : inputs) {
+        const int rows = 3 * ((input / 32) * (input / 32) + (input / 16) * (input / 16));
+        const cv::Size size(input, input);
+        for (const double objects : { 0.01, 0.1 }) {
+            const cv::Mat out = synthesize(rows, classes, objects, rng);
+            Candidates decoded, reference;
+            decoded.reserve(rows);
+            reference.reserve(rows);
+
+            const auto region = bench::run([&] {
+                decoded.clear();
+                decodeRegion(out, size, threshold, decoded);
+            }, runs);
+            const auto minmaxloc = bench::run([&] {
+                reference.clear();
+                decodeMinMaxLoc(out, size, threshold, reference);
+            }, runs);
+
+            const std::string name = std::to_string(input) + "x" + std::to_string(input) + " rows=" + std::to_string(rows)
+                                     + " objects=" + std::to_string((int) (objects * 100)) + "%";
+            std::printf("%s candidates=%zu\n", name.c_str(), decoded.size());
+            bench::report("  RegionDecoder", region);
+            bench::report("  cv::minMaxLoc", minmaxloc);
+            std::printf("  speedup=%.1fx\n", minmaxloc.mean() / region.mean());
+            if (!same(decoded, reference)) {
+                std::printf("  candidates differ\n");
+                ok = false;
+            }
+        }
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
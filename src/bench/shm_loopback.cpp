@@ -0,0 +1,190 @@
+#include <ShmSender.hpp>
+#include <ShmReceiver.hpp>
+#include <Histogram.hpp>
+#include <bench.hpp>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// size of the frames, a BGR frame of the camera
+static const int ROWS = 480;
+
+static const int COLS = 640;
+
+static const size_t STEP = COLS * 3;
+
+// CV_8UC3, the segment only passes the type on
+static const int TYPE = 16;
+
+// frames are tagged with their sequence number plus this, the tag must come with the frame
+static const uint64_t TAG = 1000;
+
+// steady clock is CLOCK_MONOTONIC on Linux, its time is the same in both processes
+static uint64_t now() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// the first row starts with the sequence number and the time of publishing, the rest is derived from the number
+static void fill(unsigned char *data, uint64_t seq) {
+    for (int y = 0; y < ROWS; ++y) {
+        std::memset(data + y * STEP, (unsigned char) (seq + y), STEP);
+    }
+    const uint64_t published = now();
+    std::memcpy(data, &seq, sizeof(seq));
+    std::memcpy(data + sizeof(seq), &published, sizeof(published));
+}
+
+static bool intact(const shared_ring::Frame &frame) {
+    if (frame.rows != ROWS || frame.cols != COLS || frame.type != TYPE || frame.step != STEP) {
+        return false;
+    }
+    uint64_t seq;
+    std::memcpy(&seq, frame.data, sizeof(seq));
+    if (seq != frame.seq || frame.tag != seq + TAG) {
+        return false;
+    }
+    for (int y = 0; y < ROWS; ++y) {
+        const unsigned char *row = frame.data + y * STEP;
+        for (size_t x = y == 0 ? 2 * sizeof(uint64_t) : 0; x < STEP; ++x) {
+            if (row[x] != (unsigned char) (seq + y)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/***
+ * receiver process, reads until the sender closes the segment or, if leave is
+ * not 0, detaches once it has read a frame with at least that sequence number
+ * @param name
+ * @param leave
+ * @param last sequence number of the last frame published, 0 if unknown
+ * @return exit status
+ */
+static int receive(const std::string &name, uint64_t leave, uint64_t last) {
+    ShmReceiver receiver;
+    receiver.connect(name);
+    Histogram latency;
+    shared_ring::Frame frame;
+    uint64_t corrupt = 0, reordered = 0, first = 0, previous = 0;
+    while (receiver.read(frame, 2000.0)) {
+        const uint64_t read = now();
+        uint64_t published = 0;
+        std::memcpy(&published, frame.data + sizeof(uint64_t), sizeof(published));
+        latency.record(read - published);
+        if (!intact(frame)) {
+            corrupt += 1;
+        } else if (frame.seq <= previous) {
+            reordered += 1;
+        }
+        if (first == 0) {
+            first = frame.seq;
+        }
+        previous = frame.seq;
+        if (leave != 0 && frame.seq >= leave) {
+            break;
+        }
+    }
+    const bool closed = !receiver.isOpen();
+    std::printf("receiver %d: frames=%llu dropped=%llu seq=%llu..%llu corrupt=%llu reordered=%llu\n", (int) getpid(),
+                (unsigned long long) receiver.frames(), (unsigned long long) receiver.dropped(),
+                (unsigned long long) first, (unsigned long long) previous, (unsigned long long) corrupt,
+                (unsigned long long) reordered);
+    bench::report("  publish to read", latency.snapshot());
+
+    bool ok = true;
+    if (corrupt > 0 || reordered > 0) {
+        std::printf("FAIL: frames read corrupt or out of order\n");
+        ok = false;
+    }
+    if (first == 0 || receiver.frames() + receiver.dropped() != previous - first + 1) {
+        std::printf("FAIL: frames neither read nor counted as dropped\n");
+        ok = false;
+    }
+    if (leave == 0 && (!closed || previous != last)) {
+        std::printf("FAIL: last frame or end of the stream not seen\n");
+        ok = false;
+    }
+    std::fflush(stdout);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// start a receiver process and wait until it has attached
+static pid_t attach(ShmSender &sender, const std::string &name, uint64_t leave, uint64_t last) {
+    std::fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        int status = EXIT_FAILURE;
+        try {
+            status = receive(name, leave, last);
+        } catch (std::exception &ex) {
+            std::printf("receiver: %s\n", ex.what());
+        }
+        std::fflush(stdout);
+        _exit(status);
+    }
+    while (!sender.isOpen()) {
+        if (waitpid(pid, nullptr, WNOHANG) != 0) {
+            return -1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return pid;
+}
+
+static bool succeeded(pid_t pid) {
+    int status = 0;
+    return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+/***
+ * Passes raw 640x480 BGR frames from this process to a receiver process through
+ * the shared memory segment of a port, like rchost and the monitor with
+ * STREAM_TRANSPORT=SHM. The first receiver detaches halfway and a second one
+ * attaches, like a monitor that reconnects. Every frame read must be intact and
+ * in order, every frame in between must be counted as dropped and the second
+ * receiver must see the last frame and the end of the stream. Reports the time
+ * from publishing to reading a frame.
+ * usage: shm_loopback [frames] [port]
+ */
+int main(int argc, const char *argv[]) {
+    const uint64_t frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000;
+    const int port = argc > 2 ? std::atoi(argv[2]) : 45200;
+    const std::string name = shared_ring::name(port);
+
+    ShmSender sender;
+    sender.open(name, ROWS * STEP);
+
+    bool ok = true;
+    pid_t receiver = attach(sender, name, frames / 2, 0);
+    bool second = false;
+    while (receiver > 0 && sender.frames() < frames) {
+        const uint64_t seq = sender.frames() + 1;
+        fill(sender.acquire(ROWS * STEP), seq);
+        if (!sender.publish(ROWS, COLS, TYPE, STEP, seq + TAG)) {
+            if (second) {
+                break;
+            }
+            // the first receiver has left, the next one has to pick up where it was
+            ok &= succeeded(receiver);
+            receiver = attach(sender, name, 0, frames);
+            second = true;
+            continue;
+        }
+        // about 500 frames per second
+        std::this_thread::sleep_for(std::chrono::microseconds(2000));
+    }
+    std::printf("sender: frames=%llu\n", (unsigned long long) sender.frames());
+    sender.close();
+    ok &= second && succeeded(receiver);
+    if (!ok) {
+        std::printf("FAIL\n");
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,139 @@
+#include <UdpSender.hpp>
+#include <UdpReceiver.hpp>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// frames are tagged with their number plus this, the tag must come with the frame
+static const uint32_t TAG = 1000;
+
+// every frame starts with its number, the rest is derived from it
+static void fill(std::vector<unsigned char> &frame, uint32_t n) {
+    std::memcpy(frame.data(), &n, sizeof(n));
+    for (size_t i = sizeof(n); i < frame.size(); ++i) {
+        frame[i] = (unsigned char) (n * 31 + i);
+    }
+}
+
+static bool intact(const std::vector<unsigned char> &frame) {
+    uint32_t n;
+    if (frame.size() < sizeof(n)) {
+        return false;
+    }
+    std::memcpy(&n, frame.data(), sizeof(n));
+    for (size_t i = sizeof(n); i < frame.size(); ++i) {
+        if (frame[i] != (unsigned char) (n * 31 + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/***
+ * Streams frames of 5 to 60 KiB over loopback UDP with the artificial-loss shim
+ * of UdpSender and checks what arrives: every delivered frame must be intact and
+ * in order, every frame must be either delivered or counted as incomplete, the
+ * measured fragment loss must match the shim and a keyframe request must reach
+ * the sender. The sender registers the receiver with poll() like the stream server.
+ * With a frame size every frame has that size, frames that fit into a single
+ * datagram are lost entirely and their fragments have to be estimated.
+ * usage: udp_loopback [loss] [frames] [port] [frame size]
+ */
+int main(int argc, const char *argv[]) {
+    const double loss = argc > 1 ? std::strtod(argv[1], nullptr) : 0.05;
+    const unsigned int frames = argc > 2 ? (unsigned int) std::strtoul(argv[2], nullptr, 10) : 500;
+    const auto port = (unsigned short) (argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 45100);
+    const size_t frame_size = argc > 4 ? std::max<size_t>(std::strtoul(argv[4], nullptr, 10), sizeof(uint32_t)) : 0;
+
+    UdpSender sender;
+    sender.open(port);
+    sender.setLoss(loss);
+
+    UdpReceiver receiver;
+    receiver.connect("127.0.0.1", port);
+    receiver.setDeadline(50.0);
+
+    std::atomic_bool keyframe_requested(false);
+    std::thread sending([&] {
+        while (!sender.poll()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        sender.joined();
+        std::mt19937 rng(42);
+        std::vector<unsigned char> frame;
+        for (uint32_t n = 0; n < frames; ++n) {
+            frame.resize(frame_size > 0 ? frame_size : 5 * 1024 + rng() % (55 * 1024));
+            fill(frame, n);
+            // tagged like rchost tags a frame with its number
+            sender.send(frame, TAG + n);
+            if (sender.joined()) {
+                keyframe_requested = true;
+            }
+            // about 300 frames per second, the receiver keeps up
+            std::this_thread::sleep_for(std::chrono::milliseconds(3));
+        }
+    });
+
+    std::vector<unsigned char> frame;
+    uint64_t delivered = 0, corrupt = 0, reordered = 0;
+    int64_t last = -1;
+    bool requested = false;
+    while (receiver.read(frame, 500.0)) {
+        uint32_t n = 0;
+        std::memcpy(&n, frame.data(), std::min(frame.size(), sizeof(n)));
+        if (!intact(frame) || receiver.tag() != TAG + n) {
+            corrupt += 1;
+        } else if ((int64_t) n <= last) {
+            reordered += 1;
+        }
+        last = n;
+        delivered += 1;
+        // like a receiver that has lost a frame of an inter-frame codec
+        if (!requested && n >= frames / 4) {
+            receiver.requestKeyframe();
+            requested = true;
+        }
+    }
+    sending.join();
+
+    const UdpReceiver::Stats stats = receiver.stats();
+    const double shim = sender.datagrams() > 0 ? double(sender.dropped()) / double(sender.datagrams()) : 0.0;
+    std::cout << "sent frames=" << sender.frames() << " datagrams=" << sender.datagrams() << " shim dropped="
+              << sender.dropped() << " (" << shim * 100.0 << "%)" << std::endl;
+    std::cout << "received " << stats << std::endl;
+    std::printf("delivered=%llu corrupt=%llu reordered=%llu\n", (unsigned long long) delivered,
+                (unsigned long long) corrupt, (unsigned long long) reordered);
+
+    bool ok = true;
+    if (corrupt > 0 || reordered > 0) {
+        std::printf("FAIL: frames delivered corrupt or out of order\n");
+        ok = false;
+    }
+    // frames lost after the last delivered one cannot be told apart from the end of the stream
+    if (stats.frames + stats.incomplete > frames || stats.frames + stats.incomplete + 1 < frames) {
+        std::printf("FAIL: %u frames sent, %llu delivered and %llu incomplete\n", frames,
+                    (unsigned long long) stats.frames, (unsigned long long) stats.incomplete);
+        ok = false;
+    }
+    if (loss == 0.0 && stats.frames != frames) {
+        std::printf("FAIL: frames lost without loss\n");
+        ok = false;
+    }
+    if (std::fabs(stats.loss() - shim) > 0.02) {
+        std::printf("FAIL: measured loss %.2f%% differs from the shim\n", stats.loss() * 100.0);
+        ok = false;
+    }
+    if (!keyframe_requested) {
+        std::printf("FAIL: keyframe request did not reach the sender\n");
+        ok = false;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
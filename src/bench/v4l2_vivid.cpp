@@ -0,0 +1,219 @@
+#include <V4L2Capture.hpp>
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/videodev2.h>
+
+// exit status ctest counts as skipped
+static const int SKIPPED = 77;
+
+static const int WIDTH = 640;
+
+static const int HEIGHT = 480;
+
+// frames read per format, several times the number of buffers so every buffer has to come back
+static const int FRAMES = 32;
+
+// in msec, vivid runs at 30 frames per second or less
+static const int TIMEOUT = 2000;
+
+struct Device {
+
+    std::string path;
+
+    std::string driver;
+
+    std::vector<uint32_t> formats;
+
+};
+
+// driver and capture formats of a device node, false if it is no capture device
+static bool query(const std::string &path, Device &device) {
+    const int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd < 0) {
+        return false;
+    }
+    struct v4l2_capability cap = { 0 };
+    bool capture = ioctl(fd, VIDIOC_QUERYCAP, &cap) == 0;
+    if (capture) {
+        const uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+        capture = (caps & V4L2_CAP_VIDEO_CAPTURE) && (caps & V4L2_CAP_STREAMING);
+    }
+    if (capture) {
+        device.path = path;
+        device.driver = (const char *) cap.driver;
+        device.formats.clear();
+        struct v4l2_fmtdesc desc = { 0 };
+        desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        while (ioctl(fd, VIDIOC_ENUM_FMT, &desc) == 0) {
+            device.formats.push_back(desc.pixelformat);
+            desc.index += 1;
+        }
+    }
+    ::close(fd);
+    return capture;
+}
+
+// the vivid devices among /dev/video*
+static std::vector<Device> vivid() {
+    std::vector<Device> devices;
+    DIR *dir = opendir("/dev");
+    if (dir == nullptr) {
+        return devices;
+    }
+    while (struct dirent *entry = readdir(dir)) {
+        Device device;
+        if (std::strncmp(entry->d_name, "video", 5) == 0 && query(std::string("/dev/") + entry->d_name, device)
+                && device.driver == "vivid") {
+            devices.push_back(device);
+        }
+    }
+    closedir(dir);
+    return devices;
+}
+
+static bool offers(const Device &device, V4L2Capture::pixel_format_t format) {
+    for (uint32_t f : device.formats) {
+        if (f == (uint32_t) format) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the buffer must be a whole frame of the negotiated format
+static bool valid(const V4L2Capture &capture, const V4L2Capture::Buffer &buffer) {
+    if (buffer.index < 0 || buffer.data.empty()) {
+        return false;
+    }
+    if (capture.format() == V4L2Capture::YUYV) {
+        if (buffer.data.rows != capture.height() || buffer.data.cols != capture.width()
+                || buffer.data.type() != CV_8UC2) {
+            return false;
+        }
+        // the test pattern is never all black
+        return cv::countNonZero(buffer.data.reshape(1)) > 0;
+    }
+    // a JPEG starts with SOI and has more than its headers
+    return buffer.data.rows == 1 && buffer.data.cols > 128 && buffer.data.type() == CV_8UC1
+           && buffer.data.data[0] == 0xFF && buffer.data.data[1] == 0xD8;
+}
+
+/***
+ * capture from a device in one format, check every buffer and that the driver keeps
+ * delivering only as long as the buffers are given back with requeue()
+ * @param path
+ * @param format
+ * @return false on any failure
+ */
+static bool check(const std::string &path, V4L2Capture::pixel_format_t format) {
+    const char *name = format == V4L2Capture::YUYV ? "YUYV" : "MJPEG";
+    V4L2Capture capture(path, WIDTH, HEIGHT, format);
+    std::printf("%s %s %dx%d fps=%.1f\n", path.c_str(), name, capture.width(), capture.height(), capture.fps());
+
+    V4L2Capture::Buffer buffer;
+    cv::Mat image;
+    uint32_t previous = 0;
+    for (int i = 0; i < FRAMES; ++i) {
+        if (!capture.dequeue(buffer, TIMEOUT)) {
+            std::printf("FAIL: %s frame %d not delivered, buffers are not requeued\n", name, i);
+            return false;
+        }
+        if (!valid(capture, buffer)) {
+            std::printf("FAIL: %s frame %d is not a valid buffer\n", name, i);
+            return false;
+        }
+        if (i > 0 && buffer.sequence <= previous) {
+            std::printf("FAIL: %s frame %d out of sequence\n", name, i);
+            return false;
+        }
+        previous = buffer.sequence;
+        capture.retrieve(buffer, image);
+        if (image.rows != capture.height() || image.cols != capture.width() || image.type() != CV_8UC3) {
+            std::printf("FAIL: %s frame %d cannot be converted\n", name, i);
+            return false;
+        }
+        capture.requeue(buffer);
+        if (buffer.index != -1 || !buffer.data.empty()) {
+            std::printf("FAIL: %s buffer still valid after requeue\n", name);
+            return false;
+        }
+    }
+
+    // hold every buffer, the driver has to stop until one is given back
+    std::vector<V4L2Capture::Buffer> held;
+    while (held.size() < 64 && capture.dequeue(buffer, TIMEOUT / 4)) {
+        held.push_back(buffer);
+    }
+    if (held.size() < 2 || held.size() >= 64) {
+        std::printf("FAIL: %s delivered %zu frames without requeue\n", name, held.size());
+        return false;
+    }
+    capture.requeue(held.front());
+    if (!capture.dequeue(buffer, TIMEOUT) || !valid(capture, buffer)) {
+        std::printf("FAIL: %s no frame after requeue\n", name);
+        return false;
+    }
+    std::printf("%s %d frames, %zu held until requeue\n", name, FRAMES, held.size());
+    return true;
+}
+
+/***
+ * Captures from the virtual vivid driver (modprobe vivid) with V4L2Capture in
+ * YUYV and MJPEG. Every buffer must hold a whole frame of the negotiated format
+ * and convert to BGR, the driver has to keep delivering as buffers are requeued
+ * and stop while all of them are held. A format vivid does not offer is left out,
+ * without a vivid device the test is skipped.
+ * usage: v4l2_vivid [device]
+ */
+int main(int argc, const char *argv[]) {
+    std::vector<Device> devices;
+    Device device;
+    if (argc > 1) {
+        if (query(argv[1], device)) {
+            devices.push_back(device);
+        }
+    } else {
+        devices = vivid();
+    }
+    if (devices.empty()) {
+        std::printf("no vivid device, skipped\n");
+        return SKIPPED;
+    }
+
+    bool ok = true;
+    int checked = 0;
+    for (V4L2Capture::pixel_format_t format : { V4L2Capture::YUYV, V4L2Capture::MJPEG }) {
+        const char *name = format == V4L2Capture::YUYV ? "YUYV" : "MJPEG";
+        const Device *found = nullptr;
+        for (const Device &d : devices) {
+            if (offers(d, format)) {
+                found = &d;
+                break;
+            }
+        }
+        if (found == nullptr) {
+            std::printf("%s not offered by %s, left out\n", name, devices.front().path.c_str());
+            continue;
+        }
+        try {
+            ok &= check(found->path, format);
+        } catch (std::exception &ex) {
+            std::printf("FAIL: %s %s\n", name, ex.what());
+            ok = false;
+        }
+        checked += 1;
+    }
+    if (checked == 0) {
+        std::printf("neither YUYV nor MJPEG offered, skipped\n");
+        return SKIPPED;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,126 @@
+#include <BoxTracker.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video.hpp>
+#include <algorithm>
+#include <cmath>
+
+// median of the values, reorders them
+static float _median(std::vector<float> &values) {
+    const auto mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    return *mid;
+}
+
+void BoxTracker::setScale(double scale) {
+    CV_Assert(scale > 0.0 && scale <= 1.0);
+    _scale = scale;
+}
+
+void BoxTracker::setMaxFeatures(int features) {
+    CV_Assert(features > 0);
+    _max_features = features;
+}
+
+void BoxTracker::setMinFeatures(int features) {
+    CV_Assert(features > 0);
+    _min_features = features;
+}
+
+void BoxTracker::init(const cv::Mat &frame, const std::vector<Prediction> &predictions) {
+    clear();
+    toGray(frame, _prev_gray);
+    const cv::Rect bounds(0, 0, _prev_gray.cols, _prev_gray.rows);
+
+    for (const auto &pred : predictions) {
+        // search features in the box in tracking image coordinates
+        const cv::Rect roi = cv::Rect((int) (pred.rect.x * _scale), (int) (pred.rect.y * _scale),
+                                      (int) (pred.rect.width * _scale), (int) (pred.rect.height * _scale)) & bounds;
+        if (roi.width < 4 || roi.height < 4) {
+            continue;
+        }
+
+        Track track;
+        track.prediction = pred;
+        track.position = cv::Point2f((float) pred.rect.x, (float) pred.rect.y);
+        cv::goodFeaturesToTrack(_prev_gray(roi), track.points, _max_features, 0.01, 3.0);
+        if ((int) track.points.size() < _min_features) {
+            continue;
+        }
+        for (auto &p : track.points) {
+            p.x += (float) roi.x;
+            p.y += (float) roi.y;
+        }
+        _tracks.emplace_back(std::move(track));
+    }
+    _initial_tracks = predictions.size();
+}
+
+double BoxTracker::update(const cv::Mat &frame, std::vector<Prediction> &predictions) {
+    predictions.clear();
+    if (_initial_tracks == 0) {
+        return 1.0;
+    }
+
+    cv::Mat gray;
+    toGray(frame, gray);
+
+    // follow the features of all boxes at once
+    std::vector<cv::Point2f> prev_points, next_points;
+    for (const auto &track : _tracks) {
+        prev_points.insert(prev_points.end(), track.points.begin(), track.points.end());
+    }
+    if (!prev_points.empty()) {
+        std::vector<unsigned char> status;
+        std::vector<float> error;
+        cv::calcOpticalFlowPyrLK(_prev_gray, gray, prev_points, next_points, status, error,
+                                 cv::Size(15, 15), 2);
+
+        size_t offset = 0;
+        std::vector<float> dx, dy;
+        std::vector<Track> tracks;
+        for (auto &track : _tracks) {
+            dx.clear();
+            dy.clear();
+            std::vector<cv::Point2f> points;
+            for (size_t i = offset; i < offset + track.points.size(); ++i) {
+                if (status[i]) {
+                    dx.push_back(next_points[i].x - prev_points[i].x);
+                    dy.push_back(next_points[i].y - prev_points[i].y);
+                    points.push_back(next_points[i]);
+                }
+            }
+            offset += track.points.size();
+            if ((int) points.size() < _min_features) {
+                continue;
+            }
+
+            // move box by the median feature displacement, robust against outliers
+            track.position.x += (float) (_median(dx) / _scale);
+            track.position.y += (float) (_median(dy) / _scale);
+            track.prediction.rect.x = (int) std::lround(track.position.x);
+            track.prediction.rect.y = (int) std::lround(track.position.y);
+            track.points = std::move(points);
+            predictions.push_back(track.prediction);
+            tracks.emplace_back(std::move(track));
+        }
+        _tracks = std::move(tracks);
+    }
+
+    _prev_gray = gray;
+    return double(_tracks.size()) / double(_initial_tracks);
+}
+
+void BoxTracker::clear() {
+    _tracks.clear();
+    _initial_tracks = 0;
+}
+
+void BoxTracker::toGray(const cv::Mat &frame, cv::Mat &gray) const {
+    cv::Mat scaled;
+    if (_scale < 1.0) {
+        cv::resize(frame, scaled, cv::Size(), _scale, _scale, cv::INTER_AREA);
+    } else {
+        scaled = frame;
+    }
+    cv::cvtColor(scaled, gray, cv::COLOR_BGR2GRAY);
+}
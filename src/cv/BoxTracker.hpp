@@ -0,0 +1,90 @@
+#ifndef __BOXTRACKER_HPP
+#define __BOXTRACKER_HPP
+
+#include <vector>
+#include <opencv2/core.hpp>
+#include <ObjectDetector.hpp>
+
+/***
+ * Propagates detector output to frames the detector has not been run on.
+ * Corner features are picked inside every box of the last detection and
+ * followed with sparse pyramidal Lucas-Kanade optical flow on a downscaled
+ * grayscale copy of the frame. Every box is moved by the median displacement
+ * of its features, boxes that lose too many features are dropped.
+ * The box size is kept constant between two detections.
+ */
+class BoxTracker {
+public:
+
+    /// default constructor
+    BoxTracker() = default;
+
+    /***
+     * set the factor frames are downscaled with before tracking
+     * @param scale in (0, 1]
+     */
+    void setScale(double scale);
+
+    /***
+     * set the maximum number of features tracked per box
+     * @param features
+     */
+    void setMaxFeatures(int features);
+
+    /***
+     * set the minimum number of features a box needs to keep being tracked
+     * @param features
+     */
+    void setMinFeatures(int features);
+
+    /***
+     * start tracking the predictions made on a frame
+     * @param frame BGR image the predictions have been made on
+     * @param predictions
+     */
+    void init(const cv::Mat &frame, const std::vector<Prediction> &predictions);
+
+    /***
+     * follow the tracked boxes to the next frame
+     * @param frame BGR image
+     * @param predictions boxes that are still tracked, in frame coordinates
+     * @return fraction of the initial boxes that are still tracked, 1 if there were none
+     */
+    double update(const cv::Mat &frame, std::vector<Prediction> &predictions);
+
+    /***
+     * stop tracking all boxes
+     */
+    void clear();
+
+private:
+
+    struct Track {
+
+        Prediction prediction;
+
+        // exact box position in frame coordinates, avoids accumulating rounding errors
+        cv::Point2f position;
+
+        // feature positions in tracking image coordinates
+        std::vector<cv::Point2f> points;
+
+    };
+
+    void toGray(const cv::Mat &frame, cv::Mat &gray) const;
+
+    std::vector<Track> _tracks;
+
+    cv::Mat _prev_gray;
+
+    size_t _initial_tracks = 0;
+
+    double _scale = 0.5;
+
+    int _max_features = 20;
+
+    int _min_features = 4;
+
+};
+
+#endif // __BOXTRACKER_HPP
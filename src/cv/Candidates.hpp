@@ -0,0 +1,77 @@
+#ifndef __CANDIDATES_HPP
+#define __CANDIDATES_HPP
+
+#include <vector>
+#include <cstddef>
+#include <opencv2/core.hpp>
+
+/***
+ * Detection candidates stored as structure of arrays, so that box
+ * coordinates and scores can be processed with vector instructions.
+ * clear() keeps the allocated memory, a Candidates object that is
+ * reused for every frame only allocates during the first frames.
+ */
+struct Candidates {
+
+    // box corners in pixels
+    std::vector<float> x1;
+
+    std::vector<float> y1;
+
+    std::vector<float> x2;
+
+    std::vector<float> y2;
+
+    std::vector<float> score;
+
+    std::vector<int> class_id;
+
+    size_t size() const {
+        return score.size();
+    }
+
+    bool empty() const {
+        return score.empty();
+    }
+
+    void clear() {
+        x1.clear();
+        y1.clear();
+        x2.clear();
+        y2.clear();
+        score.clear();
+        class_id.clear();
+    }
+
+    void reserve(size_t n) {
+        x1.reserve(n);
+        y1.reserve(n);
+        x2.reserve(n);
+        y2.reserve(n);
+        score.reserve(n);
+        class_id.reserve(n);
+    }
+
+    void push_back(float left, float top, float right, float bottom, float confidence, int id) {
+        x1.push_back(left);
+        y1.push_back(top);
+        x2.push_back(right);
+        y2.push_back(bottom);
+        score.push_back(confidence);
+        class_id.push_back(id);
+    }
+
+    /***
+     * get the box of candidate i as integer rectangle
+     * @param i
+     * @return
+     */
+    cv::Rect rect(size_t i) const {
+        const int left = (int) x1[i];
+        const int top = (int) y1[i];
+        return cv::Rect(left, top, (int) x2[i] - left, (int) y2[i] - top);
+    }
+
+};
+
+#endif // __CANDIDATES_HPP
@@ -0,0 +1,63 @@
+#include <DetectionMessage.hpp>
+#include <Protocol.hpp>
+#include <common.hpp>
+#include <cstring>
+
+template <typename T>
+static inline unsigned char* put(unsigned char *ptr, T value) {
+    value = inet_bswap(value);
+    std::memcpy(ptr, &value, sizeof(value));
+    return ptr + sizeof(value);
+}
+
+template <typename T>
+static inline const unsigned char* get(const unsigned char *ptr, T &value) {
+    std::memcpy(&value, ptr, sizeof(value));
+    value = inet_bswap(value);
+    return ptr + sizeof(value);
+}
+
+void detection_message::serialize(uint64_t frame_id, const std::vector<Prediction> &predictions,
+                                  std::vector<unsigned char> &buffer) {
+    buffer.resize(HEADER_SIZE + predictions.size() * DETECTION_SIZE);
+    unsigned char *ptr = buffer.data();
+    ptr = put(ptr, frame_id);
+    ptr = put(ptr, (uint32_t) predictions.size());
+    for (const auto &pred : predictions) {
+        const Record record = { pred.class_id, pred.confidence, pred.rect.x, pred.rect.y,
+                                pred.rect.width, pred.rect.height };
+        std::memcpy(ptr, &record, sizeof(record));
+        ptr += sizeof(record);
+    }
+    // all records are converted at once
+    protocol::swap_words(buffer.data() + HEADER_SIZE, predictions.size() * DETECTION_SIZE / sizeof(uint32_t));
+}
+
+bool detection_message::deserialize(const unsigned char *data, size_t size, uint64_t &frame_id,
+                                    std::vector<Prediction> &predictions) {
+    predictions.clear();
+    if (size < HEADER_SIZE) {
+        return false;
+    }
+
+    uint32_t n;
+    const unsigned char *ptr = get(data, frame_id);
+    ptr = get(ptr, n);
+    // n is checked against the payload before multiplying, the product wraps around with a 32 bit size_t
+    if (n > (size - HEADER_SIZE) / DETECTION_SIZE || size != HEADER_SIZE + (size_t) n * DETECTION_SIZE) {
+        return false;
+    }
+
+    std::vector<Record> records(n);
+    std::memcpy(records.data(), ptr, n * sizeof(Record));
+    protocol::swap_batch(records.data(), records.size());
+
+    predictions.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        const auto &record = records[i];
+        predictions[i].class_id = record.class_id;
+        predictions[i].confidence = record.confidence;
+        predictions[i].rect = cv::Rect(record.left, record.top, record.width, record.height);
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef __DETECTIONMESSAGE_HPP
+#define __DETECTIONMESSAGE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <ObjectDetector.hpp>
+
+/***
+ * Compact binary message carrying the predictions of a frame, so the client
+ * can draw them itself instead of the host burning them into the image.
+ * All fields have a fixed width and are in network byte order:
+ *      u64 frame id
+ *      u32 number of detections
+ * followed by every detection as
+ *      i32 class id
+ *      f32 confidence
+ *      i32 left, i32 top, i32 width, i32 height
+ * Class names are not transmitted.
+ * It is sent as payload of protocol::DETECTION_LIST messages.
+ */
+namespace detection_message {
+
+    // wire layout of a single detection, swapped as a whole
+    struct Record {
+
+        int32_t class_id;
+
+        float confidence;
+
+        int32_t left;
+
+        int32_t top;
+
+        int32_t width;
+
+        int32_t height;
+
+    };
+
+    // size of the message header in bytes
+    constexpr size_t HEADER_SIZE = 12;
+
+    // size of a single detection in bytes
+    constexpr size_t DETECTION_SIZE = 24;
+
+    static_assert(sizeof(Record) == DETECTION_SIZE, "detection record must not be padded");
+
+    /***
+     * serialize predictions, the buffer is overwritten
+     * @param frame_id
+     * @param predictions
+     * @param buffer
+     */
+    void serialize(uint64_t frame_id, const std::vector<Prediction> &predictions, std::vector<unsigned char> &buffer);
+
+    /***
+     * deserialize predictions
+     * @param data
+     * @param size
+     * @param frame_id set to the id of the frame the predictions belong to
+     * @param predictions overwritten with the predictions of the message
+     * @return false if the message is malformed
+     */
+    bool deserialize(const unsigned char *data, size_t size, uint64_t &frame_id, std::vector<Prediction> &predictions);
+
+}
+
+#endif // __DETECTIONMESSAGE_HPP
@@ -0,0 +1,83 @@
+#include <DetectorPool.hpp>
+#include <stdexcept>
+
+DetectorPool::DetectorPool(unsigned int n, const setup_t &setup) {
+    open(n, setup);
+}
+
+DetectorPool::~DetectorPool() {
+    close();
+}
+
+void DetectorPool::open(unsigned int n, const setup_t &setup) {
+    if (n == 0) {
+        throw std::invalid_argument("detector pool needs at least one detector");
+    }
+    close();
+
+    // networks are read before any thread is started, so a failing setup leaves nothing running
+    _workers.reserve(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        std::unique_ptr<Worker> worker(new Worker);
+        setup(worker->detector);
+        _workers.emplace_back(std::move(worker));
+    }
+
+    for (auto &worker : _workers) {
+        worker->thread = std::thread(&DetectorPool::work, std::ref(*worker));
+    }
+    _next = 0;
+}
+
+std::future<DetectorPool::Result> DetectorPool::submit(const cv::Mat &frame) {
+    if (!isOpened()) {
+        throw std::runtime_error("detector pool is not opened");
+    }
+
+    Task task;
+    task.frame = frame;
+    auto result = task.promise.get_future();
+
+    Worker &worker = *_workers[_next++ % _workers.size()];
+    if (!worker.tasks.push(std::move(task))) {
+        throw std::runtime_error("detector pool has been closed");
+    }
+    return result;
+}
+
+void DetectorPool::close() {
+    for (auto &worker : _workers) {
+        worker->tasks.close();
+    }
+    for (auto &worker : _workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    _workers.clear();
+}
+
+bool DetectorPool::isOpened() const {
+    return !_workers.empty();
+}
+
+size_t DetectorPool::size() const {
+    return _workers.size();
+}
+
+void DetectorPool::work(Worker &worker) {
+    Task task;
+    while (worker.tasks.pop(task)) {
+        try {
+            Result result;
+            result.predictions = worker.detector.run(task.frame);
+            result.preprocess_time = worker.detector.getPreprocessTime();
+            result.forward_time = worker.detector.getForwardTime();
+            result.postprocess_time = worker.detector.getPostprocessTime();
+            task.promise.set_value(std::move(result));
+        } catch (...) {
+            task.promise.set_exception(std::current_exception());
+        }
+        task.frame.release();
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef __DETECTORPOOL_HPP
+#define __DETECTORPOOL_HPP
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <future>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <opencv2/core.hpp>
+#include <ObjectDetector.hpp>
+#include <BoundedQueue.hpp>
+
+/***
+ * Runs several independent ObjectDetectors, each with its own cv::dnn::Net
+ * on its own thread, so that multiple frames can be in flight at once.
+ * Frames are handed to the detectors round-robin and every submission
+ * returns a future, waiting on the futures in the order they have been
+ * returned yields the predictions in submission order.
+ * The detectors share OpenCV's worker threads, the parallel layers of every
+ * forward pass are spread over all cores. What is gained are the parts of
+ * a frame that run on a single core, preprocessing, postprocessing and the
+ * serial layers of one frame overlap with the parallel layers of another.
+ */
+class DetectorPool {
+public:
+
+    /***
+     * predictions of a single frame together with the timings of its detector
+     */
+    struct Result {
+
+        std::vector<Prediction> predictions;
+
+        // durations of the stages in usec
+        uint64_t preprocess_time = 0;
+
+        uint64_t forward_time = 0;
+
+        uint64_t postprocess_time = 0;
+
+    };
+
+    // configures a freshly constructed detector, has to read the network
+    typedef std::function<void (ObjectDetector &)> setup_t;
+
+    DetectorPool() = default;
+
+    /***
+     * create the detectors and start their threads
+     * @param n number of detectors
+     * @param setup called once for every detector
+     */
+    DetectorPool(unsigned int n, const setup_t &setup);
+
+    DetectorPool(const DetectorPool &pool) = delete;
+
+    ~DetectorPool();
+
+    DetectorPool& operator=(const DetectorPool &pool) = delete;
+
+    /***
+     * create the detectors and start their threads
+     * @param n number of detectors
+     * @param setup called once for every detector
+     */
+    void open(unsigned int n, const setup_t &setup);
+
+    /***
+     * queue a frame on the next detector, blocks while that detector
+     * still has a frame waiting
+     * the frame is not copied and must not be modified before the future is ready
+     * @param frame
+     * @return future of the predictions, exceptions of the detector are rethrown by get()
+     */
+    std::future<Result> submit(const cv::Mat &frame);
+
+    /***
+     * finish the queued frames and stop all detectors
+     */
+    void close();
+
+    bool isOpened() const;
+
+    /***
+     * get the number of detectors
+     * @return
+     */
+    size_t size() const;
+
+private:
+
+    struct Task {
+
+        cv::Mat frame;
+
+        std::promise<Result> promise;
+
+    };
+
+    struct Worker {
+
+        ObjectDetector detector;
+
+        BoundedQueue<Task> tasks { 1, BoundedQueue<Task>::BLOCK };
+
+        std::thread thread;
+
+    };
+
+    static void work(Worker &worker);
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    // worker the next frame is submitted to
+    std::atomic<size_t> _next { 0 };
+
+};
+
+#endif // __DETECTORPOOL_HPP
@@ -0,0 +1,123 @@
+#include <FrameGrabber.hpp>
+#include <iostream>
+
+FrameGrabber::FrameGrabber(int device, int width, int height) {
+    open(device, width, height);
+}
+
+FrameGrabber::~FrameGrabber() {
+    close();
+}
+
+bool FrameGrabber::open(int device, int width, int height) {
+    close();
+    if (!_camera.open(device)) {
+        return false;
+    }
+
+    _camera.set(cv::CAP_PROP_FRAME_WIDTH, width);
+    _camera.set(cv::CAP_PROP_FRAME_HEIGHT, height);
+    // the grabbing thread drains the driver queue anyway, keep it as short as possible
+    _camera.set(cv::CAP_PROP_BUFFERSIZE, 1);
+
+    _mailbox.reset();
+    _running = true;
+    _thread = std::thread(&FrameGrabber::grab, this);
+    return true;
+}
+
+bool FrameGrabber::open(const std::string &device, int width, int height, V4L2Capture::pixel_format_t format,
+                            unsigned int buffers) {
+    close();
+    try {
+        _v4l2.open(device, width, height, format, buffers);
+    } catch (std::exception &ex) {
+        std::cout << ex.what() << std::endl;
+        return false;
+    }
+
+    _mailbox.reset();
+    _running = true;
+    _thread = std::thread(&FrameGrabber::grabV4L2, this);
+    return true;
+}
+
+bool FrameGrabber::read(FrameGrabber::Capture &capture) {
+    return _mailbox.read(capture);
+}
+
+void FrameGrabber::close() {
+    _running = false;
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    _mailbox.close();
+    if (_camera.isOpened()) {
+        _camera.release();
+    }
+    _v4l2.close();
+}
+
+bool FrameGrabber::isOpened() const {
+    return _camera.isOpened() || _v4l2.isOpened();
+}
+
+cv::Size FrameGrabber::getSize() const {
+    if (_v4l2.isOpened()) {
+        return cv::Size(_v4l2.width(), _v4l2.height());
+    }
+    return cv::Size((int) _camera.get(cv::CAP_PROP_FRAME_WIDTH), (int) _camera.get(cv::CAP_PROP_FRAME_HEIGHT));
+}
+
+double FrameGrabber::getFPS() const {
+    return _v4l2.isOpened() ? _v4l2.fps() : _camera.get(cv::CAP_PROP_FPS);
+}
+
+uint64_t FrameGrabber::captured() const {
+    return _mailbox.written();
+}
+
+uint64_t FrameGrabber::dropped() const {
+    return _mailbox.dropped();
+}
+
+void FrameGrabber::grab() {
+    uint64_t id = 0;
+    while (_running) {
+        // always read into a fresh image, the previous one may still be used downstream
+        Capture capture;
+        if (!_camera.read(capture.image) || capture.image.empty()) {
+            std::cout << "cannot acquire camera image" << std::endl;
+            break;
+        }
+        capture.timestamp = std::chrono::steady_clock::now();
+        capture.id = id++;
+        _mailbox.write(std::move(capture));
+    }
+    _mailbox.close();
+}
+
+void FrameGrabber::grabV4L2() {
+    V4L2Capture::Buffer buffer;
+    try {
+        while (_running) {
+            // wake up regularly to check whether the grabber has been closed
+            if (!_v4l2.dequeue(buffer, 100)) {
+                continue;
+            }
+            // convert straight from the driver buffer and give it back right away
+            Capture capture;
+            _v4l2.retrieve(buffer, capture.image);
+            capture.timestamp = buffer.timestamp;
+            capture.id = buffer.sequence;
+            _v4l2.requeue(buffer);
+            if (!capture.image.empty()) {
+                _mailbox.write(std::move(capture));
+            }
+        }
+    } catch (std::exception &ex) {
+        std::cout << ex.what() << std::endl;
+        std::cout << "cannot acquire camera image" << std::endl;
+    }
+    _mailbox.close();
+}
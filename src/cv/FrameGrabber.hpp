@@ -0,0 +1,134 @@
+#ifndef __FRAMEGRABBER_HPP
+#define __FRAMEGRABBER_HPP
+
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <Mailbox.hpp>
+#include <V4L2Capture.hpp>
+
+/***
+ * Reads camera images on a dedicated thread as fast as the camera
+ * delivers them and keeps only the newest one.
+ * Consumers that are slower than the camera therefore always get the
+ * freshest image instead of one that has been sitting in the driver's
+ * buffer queue, images that are never read are counted as dropped.
+ * Images are either read through cv::VideoCapture or directly from
+ * the memory mapped buffers of a V4L2Capture.
+ */
+class FrameGrabber {
+public:
+
+    /***
+     * image as it has been captured
+     */
+    struct Capture {
+
+        // sequence number of the image
+        uint64_t id = 0;
+
+        // time the image has been dequeued from the camera
+        std::chrono::steady_clock::time_point timestamp;
+
+        cv::Mat image;
+
+    };
+
+    FrameGrabber() = default;
+
+    /***
+     * open camera and start grabbing
+     * @param device camera index
+     * @param width requested frame width
+     * @param height requested frame height
+     */
+    FrameGrabber(int device, int width, int height);
+
+    FrameGrabber(const FrameGrabber &grabber) = delete;
+
+    ~FrameGrabber();
+
+    FrameGrabber& operator=(const FrameGrabber &grabber) = delete;
+
+    /***
+     * open camera and start grabbing
+     * @param device camera index
+     * @param width requested frame width
+     * @param height requested frame height
+     * @return false if the camera cannot be accessed
+     */
+    bool open(int device, int width, int height);
+
+    /***
+     * open camera with the native V4L2 backend and start grabbing
+     * @param device path to the device node
+     * @param width requested frame width
+     * @param height requested frame height
+     * @param format pixel format delivered by the camera
+     * @param buffers number of driver buffers
+     * @return false if the camera cannot be accessed
+     */
+    bool open(const std::string &device, int width, int height, V4L2Capture::pixel_format_t format,
+                unsigned int buffers=4);
+
+    /***
+     * wait for an image that has not been read before
+     * @param capture
+     * @return false if the grabber has been stopped or the camera failed
+     */
+    bool read(Capture &capture);
+
+    /***
+     * stop grabbing thread and release camera
+     */
+    void close();
+
+    bool isOpened() const;
+
+    /***
+     * get the size of the grabbed images
+     * @return
+     */
+    cv::Size getSize() const;
+
+    /***
+     * get the frame rate reported by the camera, 0 if unknown
+     * @return
+     */
+    double getFPS() const;
+
+    /***
+     * get the number of images read from the camera
+     * @return
+     */
+    uint64_t captured() const;
+
+    /***
+     * get the number of images that have been replaced by a newer one before they were read
+     * @return
+     */
+    uint64_t dropped() const;
+
+private:
+
+    void grab();
+
+    void grabV4L2();
+
+    cv::VideoCapture _camera;
+
+    V4L2Capture _v4l2;
+
+    Mailbox<Capture> _mailbox;
+
+    std::thread _thread;
+
+    std::atomic_bool _running { false };
+
+};
+
+#endif // __FRAMEGRABBER_HPP
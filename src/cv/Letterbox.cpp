@@ -0,0 +1,205 @@
+#include <Letterbox.hpp>
+#include <algorithm>
+#include <cmath>
+
+// fixed point precision of the interpolation weights
+#define INTER_BITS      11
+#define INTER_ONE       (1 << INTER_BITS)
+
+// writes an interpolated pixel value into a channel of an 8 bit blob as it is
+struct ByteStore {
+
+    typedef unsigned char value_type;
+
+    void operator()(unsigned char *dst, int value) const {
+        *dst = (unsigned char) value;
+    }
+
+};
+
+// writes an interpolated pixel value into a channel of a float blob, scale and mean
+// are looked up in the table of the channel
+struct FloatStore {
+
+    typedef float value_type;
+
+    const float *lut;
+
+    void operator()(float *dst, int value) const {
+        *dst = lut[value];
+    }
+
+};
+
+void Letterbox::setSize(const cv::Size &size) {
+    CV_Assert(size.width > 0 && size.height > 0);
+    _size = size;
+    _dirty = true;
+}
+
+void Letterbox::setScale(double scale) {
+    _scale = scale;
+    _dirty = true;
+}
+
+void Letterbox::setMean(const cv::Scalar &mean) {
+    _mean = mean;
+    _dirty = true;
+}
+
+void Letterbox::setSwapRB(bool swap) {
+    _swap_rb = swap;
+}
+
+void Letterbox::setDDepth(int ddepth) {
+    CV_Assert(ddepth == CV_8U || ddepth == CV_32F);
+    _ddepth = ddepth;
+}
+
+void Letterbox::setPadValue(int value) {
+    CV_Assert(value >= 0 && value <= 255);
+    _pad_value = value;
+}
+
+const cv::Size& Letterbox::getSize() const {
+    return _size;
+}
+
+const cv::Mat& Letterbox::run(const cv::Mat &frame) {
+    CV_Assert(!frame.empty() && frame.type() == CV_8UC3);
+    CV_Assert(_size.width > 0 && _size.height > 0);
+
+    if (_dirty || frame.cols != _frame_size.width || frame.rows != _frame_size.height) {
+        updateTables(cv::Size(frame.cols, frame.rows));
+    }
+
+    // allocates only if size or depth have changed
+    const int shape[] = { 1, 3, _size.height, _size.width };
+    _blob.create(4, shape, _ddepth);
+
+    if (_ddepth == CV_8U) {
+        const ByteStore stores[3] = {};
+        convert(frame, stores);
+    } else {
+        const float *lut = _lut.data();
+        const FloatStore stores[3] = { { lut }, { lut + 256 }, { lut + 2 * 256 } };
+        convert(frame, stores);
+    }
+    return _blob;
+}
+
+cv::Rect Letterbox::mapBack(const cv::Rect &rect) const {
+    const int left = (int) std::lround((rect.x - _roi.x) / _ratio);
+    const int top = (int) std::lround((rect.y - _roi.y) / _ratio);
+    const int right = (int) std::lround((rect.x + rect.width - _roi.x) / _ratio);
+    const int bottom = (int) std::lround((rect.y + rect.height - _roi.y) / _ratio);
+    const int x = std::max(0, std::min(left, _frame_size.width - 1));
+    const int y = std::max(0, std::min(top, _frame_size.height - 1));
+    return cv::Rect(x, y, std::max(0, std::min(right, _frame_size.width) - x),
+                    std::max(0, std::min(bottom, _frame_size.height) - y));
+}
+
+void Letterbox::updateTables(const cv::Size &frame_size) {
+    _frame_size = frame_size;
+    _ratio = std::min(double(_size.width) / frame_size.width, double(_size.height) / frame_size.height);
+    const int width = std::max(1, std::min(_size.width, (int) std::lround(frame_size.width * _ratio)));
+    const int height = std::max(1, std::min(_size.height, (int) std::lround(frame_size.height * _ratio)));
+    _roi = cv::Rect((_size.width - width) / 2, (_size.height - height) / 2, width, height);
+
+    // map the center of every blob pixel to the frame like cv::resize with INTER_LINEAR does
+    const auto build = [](int dst_size, int src_size, std::vector<int> &ofs, std::vector<int> &alpha) {
+        const double inv = double(src_size) / dst_size;
+        ofs.resize(dst_size);
+        alpha.resize(dst_size);
+        for (int i = 0; i < dst_size; ++i) {
+            const double f = (i + 0.5) * inv - 0.5;
+            int s = (int) std::floor(f);
+            int a = (int) std::lround((f - s) * INTER_ONE);
+            if (s < 0) {
+                s = 0;
+                a = 0;
+            } else if (s >= src_size - 1) {
+                s = src_size - 1;
+                a = 0;
+            }
+            ofs[i] = s;
+            alpha[i] = a;
+        }
+    };
+    build(width, frame_size.width, _x_ofs, _x_alpha);
+    build(height, frame_size.height, _y_ofs, _y_alpha);
+
+    // scale and mean are folded into a lookup table per blob channel
+    _lut.resize(3 * 256);
+    for (int c = 0; c < 3; ++c) {
+        for (int v = 0; v < 256; ++v) {
+            _lut[c * 256 + v] = (float) ((v - _mean[c]) * _scale);
+        }
+    }
+    _dirty = false;
+}
+
+template <typename Store>
+void Letterbox::convert(const cv::Mat &frame, const Store *stores) {
+    typedef typename Store::value_type T;
+    const size_t plane_size = (size_t) _size.width * _size.height;
+    T *planes[3];
+    for (int c = 0; c < 3; ++c) {
+        planes[c] = _blob.ptr<T>() + c * plane_size;
+    }
+
+    // blob channel each frame channel ends up in
+    const int order[3] = { _swap_rb ? 2 : 0, 1, _swap_rb ? 0 : 2 };
+    const int last_col = frame.cols - 1;
+    const int last_row = frame.rows - 1;
+
+    for (int y = 0; y < _size.height; ++y) {
+        const size_t row_ofs = (size_t) y * _size.width;
+        const bool inside = y >= _roi.y && y < _roi.y + _roi.height;
+        const int content_begin = inside ? _roi.x : _size.width;
+        const int content_end = inside ? _roi.x + _roi.width : _size.width;
+
+        // padding left of the content, or the whole row
+        for (int c = 0; c < 3; ++c) {
+            T *dst = planes[order[c]] + row_ofs;
+            const Store &store = stores[order[c]];
+            for (int x = 0; x < content_begin; ++x) {
+                store(dst + x, _pad_value);
+            }
+            for (int x = content_end; x < _size.width; ++x) {
+                store(dst + x, _pad_value);
+            }
+        }
+        if (!inside) {
+            continue;
+        }
+
+        const int sy = _y_ofs[y - _roi.y];
+        const int wy = _y_alpha[y - _roi.y];
+        const unsigned char *row0 = frame.ptr<unsigned char>(sy);
+        const unsigned char *row1 = frame.ptr<unsigned char>(std::min(sy + 1, last_row));
+        T *dst0 = planes[order[0]] + row_ofs;
+        T *dst1 = planes[order[1]] + row_ofs;
+        T *dst2 = planes[order[2]] + row_ofs;
+        const Store &store0 = stores[order[0]];
+        const Store &store1 = stores[order[1]];
+        const Store &store2 = stores[order[2]];
+
+        for (int x = 0; x < _roi.width; ++x) {
+            const int sx = _x_ofs[x];
+            const int wx = _x_alpha[x];
+            const int x0 = sx * 3;
+            const int x1 = std::min(sx + 1, last_col) * 3;
+            int v[3];
+            for (int c = 0; c < 3; ++c) {
+                const int top = row0[x0 + c] * (INTER_ONE - wx) + row0[x1 + c] * wx;
+                const int bottom = row1[x0 + c] * (INTER_ONE - wx) + row1[x1 + c] * wx;
+                v[c] = (top * (INTER_ONE - wy) + bottom * wy + (1 << (2 * INTER_BITS - 1))) >> (2 * INTER_BITS);
+            }
+            const int dx = _roi.x + x;
+            store0(dst0 + dx, v[0]);
+            store1(dst1 + dx, v[1]);
+            store2(dst2 + dx, v[2]);
+        }
+    }
+}
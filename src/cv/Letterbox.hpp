@@ -0,0 +1,126 @@
+#ifndef __LETTERBOX_HPP
+#define __LETTERBOX_HPP
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+/***
+ * Converts a BGR frame into a 1x3xHxW network input blob in a single pass.
+ * The frame is scaled to fit into the network size while keeping its aspect
+ * ratio and the remaining area is padded. Bilinear resampling, channel swap,
+ * scaling and mean subtraction are all done in the same loop, so the frame
+ * is read exactly once and is never modified.
+ * Boxes predicted on the blob can be mapped back to frame coordinates.
+ */
+class Letterbox {
+public:
+
+    /// default constructor
+    Letterbox() = default;
+
+    /***
+     * set the network input size
+     * @param size
+     */
+    void setSize(const cv::Size &size);
+
+    /***
+     * set the factor all pixel values are multiplied with after the mean has been subtracted
+     * only applied to CV_32F blobs, 8 bit blobs contain the raw pixel values
+     * @param scale
+     */
+    void setScale(double scale);
+
+    /***
+     * set the mean that is subtracted from each channel, in blob channel order
+     * only applied to CV_32F blobs
+     * @param mean
+     */
+    void setMean(const cv::Scalar &mean);
+
+    /***
+     * indicate whether or not red and blue channel shall be swapped
+     * @param swap
+     */
+    void setSwapRB(bool swap);
+
+    /***
+     * set the depth of the blob, either CV_8U or CV_32F
+     * @param ddepth
+     */
+    void setDDepth(int ddepth);
+
+    /***
+     * set the raw pixel value used for the padded area
+     * @param value
+     */
+    void setPadValue(int value);
+
+    /***
+     * convert frame into the blob, the returned blob is reused by the next call
+     * @param frame 8 bit BGR image
+     * @return blob of shape 1x3xHxW
+     */
+    const cv::Mat& run(const cv::Mat &frame);
+
+    /***
+     * map a rectangle from blob coordinates to the coordinates of the last converted frame
+     * @param rect
+     * @return
+     */
+    cv::Rect mapBack(const cv::Rect &rect) const;
+
+    const cv::Size& getSize() const;
+
+private:
+
+    void updateTables(const cv::Size &frame_size);
+
+    /***
+     * sample the frame into the blob
+     * @tparam Store writes a pixel value into the blob, defines the blob's value_type
+     * @param frame
+     * @param stores one per blob channel
+     */
+    template <typename Store>
+    void convert(const cv::Mat &frame, const Store *stores);
+
+    cv::Mat _blob;
+
+    cv::Size _size = cv::Size(0, 0);
+
+    cv::Size _frame_size = cv::Size(0, 0);
+
+    // frame to blob ratio and offset of the scaled frame within the blob
+    double _ratio = 1.0;
+
+    cv::Rect _roi;
+
+    // per column source offsets and weights of the bilinear interpolation
+    std::vector<int> _x_ofs;
+
+    std::vector<int> _x_alpha;
+
+    // per row source rows and weights of the bilinear interpolation
+    std::vector<int> _y_ofs;
+
+    std::vector<int> _y_alpha;
+
+    // pixel value to blob value lookup table per blob channel
+    std::vector<float> _lut;
+
+    double _scale = 1.0;
+
+    cv::Scalar _mean = cv::Scalar();
+
+    int _ddepth = CV_32F;
+
+    int _pad_value = 127;
+
+    bool _swap_rb = true;
+
+    bool _dirty = true;
+
+};
+
+#endif // __LETTERBOX_HPP
@@ -0,0 +1,54 @@
+#include <MotionGate.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+void MotionGate::setSize(const cv::Size &size) {
+    CV_Assert(size.width > 0 && size.height > 0);
+    _size = size;
+    reset();
+}
+
+void MotionGate::setBlockSize(int block) {
+    CV_Assert(block > 0);
+    _block = block;
+}
+
+void MotionGate::setThreshold(double threshold) {
+    CV_Assert(threshold >= 0.0 && threshold <= 255.0);
+    _threshold = threshold;
+}
+
+void MotionGate::setMaxSkip(unsigned int frames) {
+    _max_skip = frames;
+}
+
+bool MotionGate::changed(const cv::Mat &frame) {
+    CV_Assert(!frame.empty());
+    // downscale first so the color conversion only touches a few thousand pixels
+    cv::resize(frame, _scaled, _size, 0, 0, cv::INTER_AREA);
+    cv::cvtColor(_scaled, _gray, cv::COLOR_BGR2GRAY);
+
+    bool changed = _reference.empty() || (_max_skip > 0 && _skipped >= _max_skip);
+    if (!changed) {
+        // area interpolation averages the difference over every block
+        cv::absdiff(_gray, _reference, _diff);
+        cv::resize(_diff, _blocks, cv::Size(std::max(1, _size.width / _block), std::max(1, _size.height / _block)),
+                   0, 0, cv::INTER_AREA);
+        double max = 0.0;
+        cv::minMaxLoc(_blocks, nullptr, &max);
+        changed = max > _threshold;
+    }
+
+    if (changed) {
+        cv::swap(_reference, _gray);
+        _skipped = 0;
+    } else {
+        _skipped += 1;
+    }
+    return changed;
+}
+
+void MotionGate::reset() {
+    _reference.release();
+    _skipped = 0;
+}
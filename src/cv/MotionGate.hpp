@@ -0,0 +1,81 @@
+#ifndef __MOTIONGATE_HPP
+#define __MOTIONGATE_HPP
+
+#include <opencv2/core.hpp>
+
+/***
+ * Cheap frame difference test that tells whether a scene has changed
+ * enough to be worth running the detector again.
+ * Frames are reduced to a small grayscale copy and compared with the last
+ * frame that has passed the gate, the absolute difference is averaged over
+ * blocks and the scene counts as changed once any block exceeds the threshold.
+ * All steps use OpenCV's vectorized kernels.
+ */
+class MotionGate {
+public:
+
+    /// default constructor
+    MotionGate() = default;
+
+    /***
+     * set the size of the grayscale copy frames are compared on
+     * @param size
+     */
+    void setSize(const cv::Size &size);
+
+    /***
+     * set the edge length of a block in pixels of the grayscale copy
+     * @param block
+     */
+    void setBlockSize(int block);
+
+    /***
+     * set the mean absolute pixel difference a block must exceed
+     * @param threshold in [0, 255]
+     */
+    void setThreshold(double threshold);
+
+    /***
+     * let a frame pass after this many static frames regardless of its content, 0 disables this
+     * @param frames
+     */
+    void setMaxSkip(unsigned int frames);
+
+    /***
+     * check whether the frame differs from the last frame that has passed the gate,
+     * if it does it becomes the new reference
+     * @param frame BGR image
+     * @return true if the frame passes the gate
+     */
+    bool changed(const cv::Mat &frame);
+
+    /***
+     * let the next frame pass unconditionally
+     */
+    void reset();
+
+private:
+
+    cv::Mat _reference;
+
+    cv::Mat _scaled;
+
+    cv::Mat _gray;
+
+    cv::Mat _diff;
+
+    cv::Mat _blocks;
+
+    cv::Size _size = cv::Size(80, 60);
+
+    int _block = 8;
+
+    double _threshold = 12.0;
+
+    unsigned int _max_skip = 30;
+
+    unsigned int _skipped = 0;
+
+};
+
+#endif // __MOTIONGATE_HPP
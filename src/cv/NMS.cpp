@@ -0,0 +1,153 @@
+#include <NMS.hpp>
+#include <RegionDecoder.hpp>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+// score of boxes that have been kept or suppressed
+#define REMOVED     -1.0f
+
+void NMS::setIoUThreshold(float threshold) {
+    _iou_threshold = threshold;
+}
+
+void NMS::setScoreThreshold(float threshold) {
+    _score_threshold = threshold;
+}
+
+void NMS::setTopK(int k) {
+    _top_k = k > 0 ? k : 0;
+}
+
+void NMS::setSoftSigma(float sigma) {
+    _soft_sigma = sigma > 0.0f ? sigma : 0.0f;
+}
+
+void NMS::run(Candidates &candidates, std::vector<int> &indices) {
+    indices.clear();
+    const size_t n = candidates.size();
+    if (n == 0) {
+        return;
+    }
+
+    // sort once by class and descending score
+    _order.resize(n);
+    std::iota(_order.begin(), _order.end(), 0);
+    const auto &ids = candidates.class_id;
+    const auto &scores = candidates.score;
+    std::sort(_order.begin(), _order.end(), [&ids, &scores](int a, int b) {
+        return ids[a] != ids[b] ? ids[a] < ids[b] : scores[a] > scores[b];
+    });
+
+    // suppress every class on its own
+    size_t begin = 0;
+    while (begin < n) {
+        size_t end = begin + 1;
+        while (end < n && ids[_order[end]] == ids[_order[begin]]) {
+            ++end;
+        }
+        gather(candidates, begin, end);
+        if (_soft_sigma > 0.0f) {
+            softSuppress(candidates, indices, begin, end);
+        } else {
+            suppress(indices, begin, end);
+        }
+        begin = end;
+    }
+
+    if (_top_k > 0 && indices.size() > (size_t) _top_k) {
+        std::partial_sort(indices.begin(), indices.begin() + _top_k, indices.end(), [&scores](int a, int b) {
+            return scores[a] > scores[b];
+        });
+        indices.resize(_top_k);
+        // back into the order of an uncapped result
+        std::sort(indices.begin(), indices.end(), [&ids, &scores](int a, int b) {
+            return ids[a] != ids[b] ? ids[a] < ids[b] : scores[a] > scores[b];
+        });
+    }
+}
+
+void NMS::gather(const Candidates &candidates, size_t begin, size_t end) {
+    const size_t m = end - begin;
+    _x1.resize(m);
+    _y1.resize(m);
+    _x2.resize(m);
+    _y2.resize(m);
+    _area.resize(m);
+    _score.resize(m);
+    _iou.resize(m);
+    for (size_t k = 0; k < m; ++k) {
+        const int i = _order[begin + k];
+        _x1[k] = candidates.x1[i];
+        _y1[k] = candidates.y1[i];
+        _x2[k] = candidates.x2[i];
+        _y2[k] = candidates.y2[i];
+        _area[k] = std::max(0.0f, _x2[k] - _x1[k]) * std::max(0.0f, _y2[k] - _y1[k]);
+        _score[k] = candidates.score[i];
+    }
+}
+
+// IoU of box k against boxes [first, m), branch-free so it is vectorized
+static inline void overlap(const float *x1, const float *y1, const float *x2, const float *y2, const float *area,
+                           size_t k, size_t first, size_t m, float *iou) {
+    const float bx1 = x1[k];
+    const float by1 = y1[k];
+    const float bx2 = x2[k];
+    const float by2 = y2[k];
+    const float barea = area[k];
+    for (size_t j = first; j < m; ++j) {
+        const float w = std::max(0.0f, std::min(bx2, x2[j]) - std::max(bx1, x1[j]));
+        const float h = std::max(0.0f, std::min(by2, y2[j]) - std::max(by1, y1[j]));
+        const float inter = w * h;
+        iou[j] = inter / (barea + area[j] - inter + 1e-6f);
+    }
+}
+
+void NMS::suppress(std::vector<int> &indices, size_t begin, size_t end) {
+    const size_t m = end - begin;
+    float *score = _score.data();
+    float *iou = _iou.data();
+    const float threshold = _iou_threshold;
+
+    for (size_t k = 0; k < m; ++k) {
+        if (score[k] == REMOVED) {
+            continue;
+        }
+        // scores are sorted, no later box can reach the threshold either
+        if (score[k] < _score_threshold) {
+            break;
+        }
+        indices.push_back(_order[begin + k]);
+
+        overlap(_x1.data(), _y1.data(), _x2.data(), _y2.data(), _area.data(), k, k + 1, m, iou);
+        for (size_t j = k + 1; j < m; ++j) {
+            score[j] = iou[j] > threshold ? REMOVED : score[j];
+        }
+    }
+}
+
+void NMS::softSuppress(Candidates &candidates, std::vector<int> &indices, size_t begin, size_t end) {
+    const size_t m = end - begin;
+    float *score = _score.data();
+    float *iou = _iou.data();
+    const float inv_sigma = 1.0f / _soft_sigma;
+
+    while (true) {
+        // decayed scores are no longer sorted, pick the best remaining box
+        float best_score;
+        const auto best = (size_t) argmax(score, (int) m, best_score);
+        if (best_score < _score_threshold || best_score == REMOVED) {
+            break;
+        }
+        const int index = _order[begin + best];
+        indices.push_back(index);
+        candidates.score[index] = best_score;
+        score[best] = REMOVED;
+
+        overlap(_x1.data(), _y1.data(), _x2.data(), _y2.data(), _area.data(), best, 0, m, iou);
+        for (size_t j = 0; j < m; ++j) {
+            const float decay = std::exp(-iou[j] * iou[j] * inv_sigma);
+            score[j] = score[j] == REMOVED ? REMOVED : score[j] * decay;
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef __NMS_HPP
+#define __NMS_HPP
+
+#include <vector>
+#include <Candidates.hpp>
+
+/***
+ * Class-aware non maximum suppression on candidates stored as structure of arrays.
+ * Candidates are sorted once by class and descending score, after that every
+ * class is suppressed on its own. The boxes of a class are gathered into
+ * contiguous arrays so the IoU of a kept box against all remaining boxes is
+ * computed by a branch-free loop the compiler vectorizes.
+ * Optionally Gaussian soft-NMS decays the scores of overlapping boxes instead of
+ * discarding them, and the result can be capped to the best K boxes.
+ * All scratch memory is kept between calls.
+ */
+class NMS {
+public:
+
+    /// default constructor
+    NMS() = default;
+
+    /***
+     * set the IoU above which a box is suppressed by a better one of the same class
+     * @param threshold
+     */
+    void setIoUThreshold(float threshold);
+
+    /***
+     * set the score a box needs to be kept, relevant for soft-NMS which lowers scores
+     * @param threshold
+     */
+    void setScoreThreshold(float threshold);
+
+    /***
+     * keep at most the k best boxes over all classes, 0 keeps all
+     * @param k
+     */
+    void setTopK(int k);
+
+    /***
+     * enable Gaussian soft-NMS, scores are multiplied with exp(-iou^2 / sigma)
+     * @param sigma 0 uses hard suppression
+     */
+    void setSoftSigma(float sigma);
+
+    /***
+     * run the suppression
+     * @param candidates soft-NMS updates the scores in place
+     * @param indices indices of the kept candidates, sorted by class and descending score
+     */
+    void run(Candidates &candidates, std::vector<int> &indices);
+
+private:
+
+    void gather(const Candidates &candidates, size_t begin, size_t end);
+
+    void suppress(std::vector<int> &indices, size_t begin, size_t end);
+
+    void softSuppress(Candidates &candidates, std::vector<int> &indices, size_t begin, size_t end);
+
+    float _iou_threshold = 0.4f;
+
+    float _score_threshold = 0.0f;
+
+    int _top_k = 0;
+
+    float _soft_sigma = 0.0f;
+
+    // candidate indices sorted by class and score
+    std::vector<int> _order;
+
+    // boxes, areas and scores of the current class in sorted order
+    std::vector<float> _x1;
+
+    std::vector<float> _y1;
+
+    std::vector<float> _x2;
+
+    std::vector<float> _y2;
+
+    std::vector<float> _area;
+
+    std::vector<float> _score;
+
+    std::vector<float> _iou;
+
+};
+
+#endif // __NMS_HPP
@@ -1,12 +1,15 @@
 #include <ObjectDetector.hpp>
+#include <RegionDecoder.hpp>
+#include <MappedFile.hpp>
+#include <common.hpp>
 #include <opencv2/imgproc.hpp>
 #include <stdexcept>
+#include <chrono>
 
 void drawPredictions(cv::Mat &frame, const std::vector<Prediction> &predictions, bool drawLabels,
                                           const cv::Scalar &color, int thickness, int lineType, int shift)
 {
     CV_Assert(!frame.empty());
-    cv::error()
     for (const auto &pred : predictions) {
         // draw bounding box around object
         cv::rectangle(frame, pred.rect, color, thickness, lineType, shift);
@@ -28,46 +31,131 @@ void drawPredictions(cv::Mat &frame, const std::vector<Prediction> &predictions,
     }
 }
 
+void scalePredictions(std::vector<Prediction> &predictions, double fx, double fy) {
+    for (auto &pred : predictions) {
+        pred.rect = cv::Rect(cvRound(pred.rect.x * fx), cvRound(pred.rect.y * fy),
+                             cvRound(pred.rect.width * fx), cvRound(pred.rect.height * fy));
+    }
+}
+
+// Network produces output blob with a shape 1x1xNx7 where N is a number of
+// detections and an every detection is a vector of values
+// [batchId, classId, confidence, left, top, right, bottom]
+static void decodeDetectionOutput(const cv::Mat &out, const cv::Size &size, float threshold, Candidates &candidates) {
+    const auto data = (const float *) out.data;
+    for (size_t i = 0; i < out.total(); i += 7) {
+        const float confidence = data[i + 2];
+        if (confidence > threshold) {
+            float left   = data[i + 3];
+            float top    = data[i + 4];
+            float right  = data[i + 5];
+            float bottom = data[i + 6];
+            // normalized coordinates
+            if (right - left + 1 <= 2 || bottom - top + 1 <= 2) {
+                left   *= size.width;
+                top    *= size.height;
+                right  *= size.width;
+                bottom *= size.height;
+            }
+            // Skip 0th background class id.
+            candidates.push_back(left, top, right + 1, bottom + 1, confidence, (int) data[i + 1] - 1);
+        }
+    }
+}
+
 ObjectDetector::ObjectDetector(const cv::String &model, const cv::String &config, const cv::String &framework) {
     readNet(model, config, framework);
 }
 
+// read network from memory mapped files, formats that cannot be parsed from memory
+// are handed to cv::dnn::readNet, the files are identified like cv::dnn::readNet does
+static cv::dnn::Net mapNet(const cv::String &model, const cv::String &config, const cv::String &framework) {
+    const std::string fw = string::to_lower(framework);
+    const auto is = [&](const std::string &name, const std::string &ext0, const std::string &ext1) {
+        return fw == name || string::ends_with(model, ext0) || string::ends_with(model, ext1);
+    };
+    // model and config may be given in either order
+    const auto pick = [&](const std::string &ext) {
+        return string::ends_with(config, ext) ? config : model;
+    };
+
+    if (is("darknet", ".weights", ".cfg") && !config.empty()) {
+        MappedFile weights(pick(".weights")), cfg(pick(".weights") == model ? config : model);
+        return cv::dnn::readNetFromDarknet(cfg.data(), cfg.size(), weights.data(), weights.size());
+    } else if (is("tensorflow", ".pb", ".pbtxt")) {
+        MappedFile pb(pick(".pb"));
+        if (config.empty()) {
+            return cv::dnn::readNetFromTensorflow(pb.data(), pb.size());
+        }
+        MappedFile pbtxt(pick(".pb") == model ? config : model);
+        return cv::dnn::readNetFromTensorflow(pb.data(), pb.size(), pbtxt.data(), pbtxt.size());
+    } else if (is("caffe", ".caffemodel", ".prototxt") && !config.empty()) {
+        MappedFile caffemodel(pick(".caffemodel")), prototxt(pick(".caffemodel") == model ? config : model);
+        return cv::dnn::readNetFromCaffe(prototxt.data(), prototxt.size(), caffemodel.data(), caffemodel.size());
+    }
+    return cv::dnn::readNet(model, config, framework);
+}
+
 void ObjectDetector::readNet(const cv::String & model, const cv::String & config, const cv::String & framework) {
-    _net = cv::dnn::readNet(model, config, framework);
+    _net = mapNet(model, config, framework);
     _out_names = _net.getUnconnectedOutLayersNames();
+    _out_layer_type = _net.getLayer(_net.getUnconnectedOutLayers()[0])->type;
+    // Faster-RCNN or R-FCN take the image size as a second input
+    _im_info = _net.getLayer(0)->outputNameToIndex("im_info") != -1;
 }
 
 void ObjectDetector::setScale(double scale) {
     _scale = scale;
+    _letterbox.setScale(scale);
 }
 
 void ObjectDetector::setMean(const cv::Scalar &mean) {
     _mean = mean;
+    _letterbox.setMean(mean);
 }
 
 void ObjectDetector::setSwapRB(bool swap) {
     _swap_rb = swap;
+    _letterbox.setSwapRB(swap);
 }
 
 void ObjectDetector::setCrop(bool crop) {
     _crop = crop;
 }
 
+void ObjectDetector::setLetterbox(bool letterbox) {
+    _letterbox_enabled = letterbox;
+}
+
 void ObjectDetector::setSize(const cv::Size &size) {
     _size = size;
+    if (size.width > 0 && size.height > 0) {
+        _letterbox.setSize(size);
+    }
 }
 
 void ObjectDetector::setDDepth(int ddepth) {
     CV_Assert(ddepth == CV_8U || ddepth == CV_32F);
     _ddepth = ddepth;
+    _letterbox.setDDepth(ddepth);
 }
 
 void ObjectDetector::setNMSThreshold(float nmsThreshold) {
     _nms_threshold = nmsThreshold;
+    _nms.setIoUThreshold(nmsThreshold);
 }
 
 void ObjectDetector::setConfidenceThreshold(float confThreshold) {
     _conf_threshold = confThreshold;
+    _nms.setScoreThreshold(confThreshold);
+}
+
+void ObjectDetector::setTopK(int k) {
+    _nms.setTopK(k);
+}
+
+void ObjectDetector::setSoftNMS(float sigma) {
+    _nms.setSoftSigma(sigma);
 }
 
 void ObjectDetector::setClasses(const std::vector<std::string> &classes) {
@@ -75,16 +163,43 @@ void ObjectDetector::setClasses(const std::vector<std::string> &classes) {
 }
 
 std::vector<Prediction> ObjectDetector::run(const cv::Mat &frame) {
-    frame(cv::Rect(100, 100, 100, 100));
     CV_Assert(!frame.empty());
+    const auto begin = std::chrono::steady_clock::now();
     preprocess(frame);
+    const auto preprocessed = std::chrono::steady_clock::now();
     std::vector<cv::Mat> outs;
     _net.forward(outs, _out_names);
+    const auto forwarded = std::chrono::steady_clock::now();
     std::vector<Prediction> pred;
-    postprocess(_size == cv::Size(0, 0) ? cv::Size(frame.cols, frame.rows) : _size, outs, pred);
+    if (_letterbox_enabled) {
+        // boxes are predicted on the letterboxed blob
+        postprocess(_size, outs, pred);
+        for (auto &p : pred) {
+            p.rect = _letterbox.mapBack(p.rect);
+        }
+    } else {
+        postprocess(_size == cv::Size(0, 0) ? cv::Size(frame.cols, frame.rows) : _size, outs, pred);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    _preprocess_time = std::chrono::duration_cast<std::chrono::microseconds>(preprocessed - begin).count();
+    _forward_time = std::chrono::duration_cast<std::chrono::microseconds>(forwarded - preprocessed).count();
+    _postprocess_time = std::chrono::duration_cast<std::chrono::microseconds>(end - forwarded).count();
     return pred;
 }
 
+void ObjectDetector::warmup(unsigned int runs) {
+    if (runs == 0) {
+        return;
+    }
+    CV_Assert(_size.width > 0 && _size.height > 0);
+    // a plain grey frame, only the allocations and layer fusion of the first passes matter
+    const cv::Mat frame(_size, CV_8UC3, cv::Scalar::all(127));
+    for (unsigned int i = 0; i < runs; ++i) {
+        run(frame);
+    }
+}
+
 cv::dnn::Net& ObjectDetector::getNet() {
     return _net;
 }
@@ -97,95 +212,64 @@ float ObjectDetector::getNMSThreshold() const {
     return _nms_threshold;
 }
 
+uint64_t ObjectDetector::getPreprocessTime() const {
+    return _preprocess_time;
+}
+
+uint64_t ObjectDetector::getForwardTime() const {
+    return _forward_time;
+}
+
+uint64_t ObjectDetector::getPostprocessTime() const {
+    return _postprocess_time;
+}
+
 void ObjectDetector::preprocess(const cv::Mat &frame) {
-    static cv::Mat blob;
-    static const cv::Size size(_size.width == 0 ? frame.cols : _size.width, _size.height == 0 ? frame.rows : _size.height);
-    cv::dnn::blobFromImage(frame, blob, 1.0, size, cv::Scalar(), _swap_rb, _crop, _ddepth);
-
-    // Faster-RCNN or R-FCN
-    if (_net.getLayer(0)->outputNameToIndex("im_info") != -1) {
-        cv::resize(frame, frame, size);
-        cv::Mat imInfo = (cv::Mat_<float>(1, 3) << size.height, size.width, 1.6f);
+    if (_letterbox_enabled) {
+        CV_Assert(_size.width > 0 && _size.height > 0);
+        // scale and mean have already been applied to CV_32F blobs
+        const cv::Mat &blob = _letterbox.run(frame);
+        if (_ddepth == CV_8U) {
+            _net.setInput(blob, "", _scale, _mean);
+        } else {
+            _net.setInput(blob);
+        }
+        return;
+    }
+
+    const cv::Size size(_size.width == 0 ? frame.cols : _size.width, _size.height == 0 ? frame.rows : _size.height);
+    cv::dnn::blobFromImage(frame, _blob, 1.0, size, cv::Scalar(), _swap_rb, _crop, _ddepth);
+    _net.setInput(_blob, "", _scale, _mean);
+
+    if (_im_info) {
+        const cv::Mat imInfo = (cv::Mat_<float>(1, 3) << size.height, size.width, 1.6f);
         _net.setInput(imInfo, "im_info");
-    } else {
-        _net.setInput(blob, "", _scale, _mean);
     }
 }
 
 void ObjectDetector::postprocess(const cv::Size &size, const std::vector<cv::Mat> &outs, std::vector<Prediction> &pred) {
-    static std::vector<int> outLayers = _net.getUnconnectedOutLayers();
-    static std::string outLayerType = _net.getLayer(outLayers[0])->type;
-
-    std::vector<int> classIds;
-    std::vector<float> confidences;
-    std::vector<cv::Rect> boxes;
-    if (outLayerType == "DetectionOutput") {
-        // Network produces output blob with a shape 1x1xNx7 where N is a number of
-        // detections and an every detection is a vector of values
-        // [batchId, classId, confidence, left, top, right, bottom]
+    _candidates.clear();
+    if (_out_layer_type == "DetectionOutput") {
         for (auto &out : outs) {
-            auto data = (float *) out.data;
-            for (size_t i = 0; i < out.total(); i += 7) {
-                float confidence = data[i + 2];
-                if (confidence > _conf_threshold) {
-                    int left   = (int) data[i + 3];
-                    int top    = (int) data[i + 4];
-                    int right  = (int) data[i + 5];
-                    int bottom = (int) data[i + 6];
-                    int width  = right - left + 1;
-                    int height = bottom - top + 1;
-                    if (width <= 2 || height <= 2) {
-                        left   = (int) (data[i + 3] * size.width);
-                        top    = (int) (data[i + 4] * size.height);
-                        right  = (int) (data[i + 5] * size.width);
-                        bottom = (int) (data[i + 6] * size.height);
-                        width  = right - left + 1;
-                        height = bottom - top + 1;
-                    }
-                    // Skip 0th background class id.
-                    classIds.push_back((int) (data[i + 1]) - 1);
-                    boxes.emplace_back(cv::Rect(left, top, width, height));
-                    confidences.push_back(confidence);
-                }
-            }
+            decodeDetectionOutput(out, size, _conf_threshold, _candidates);
         }
-    } else if (outLayerType == "Region") {
+    } else if (_out_layer_type == "Region") {
+        // decode into the reused candidate arrays, rows are filtered on objectness first
         for (auto &out : outs) {
-            // Network produces output blob with a shape NxC where N is a number of
-            // detected objects and C is a number of classes + 4 where the first 4
-            // numbers are [center_x, center_y, width, height]
-            auto data = (float *) out.data;
-            for (int j = 0; j < out.rows; ++j, data += out.cols) {
-                cv::Mat scores = out.row(j).colRange(5, out.cols);
-                cv::Point classIdPoint;
-                double confidence;
-                cv::minMaxLoc(scores, nullptr, &confidence, nullptr, &classIdPoint);
-                if (confidence > _conf_threshold) {
-                    int centerX = (int)(data[0] * size.width);
-                    int centerY = (int)(data[1] * size.height);
-                    int width = (int)(data[2] * size.width);
-                    int height = (int)(data[3] * size.height);
-                    int left = centerX - width / 2;
-                    int top = centerY - height / 2;
-
-                    classIds.push_back(classIdPoint.x);
-                    confidences.push_back((float)confidence);
-                    boxes.emplace_back(cv::Rect(left, top, width, height));
-                }
-            }
+            decodeRegion(out, size, _conf_threshold, _candidates);
         }
     } else {
-        CV_Error(cv::Error::StsNotImplemented, "unknown output layer type: " + outLayerType);
+        CV_Error(cv::Error::StsNotImplemented, "unknown output layer type: " + _out_layer_type);
     }
 
-    // non maximum suppression
-    std::vector<int> indices;
-    cv::dnn::NMSBoxes(boxes, confidences, _conf_threshold, _nms_threshold, indices);
+    // class-aware non maximum suppression
+    _nms.run(_candidates, _keep);
 
-    // filter for prediction sufficing NMS threshold
-    pred.reserve(indices.size());
-    std::for_each(indices.begin(), indices.end(), [&](int idx) {
-        pred.emplace_back(Prediction(classIds[idx], boxes[idx].x, boxes[idx].y, boxes[idx].width,
-                    boxes[idx].height, confidences[idx], classIds[idx] < _classes.size() ? _classes[idx] : ""));
-    });
+    pred.reserve(_keep.size());
+    for (const int idx : _keep) {
+        const int id = _candidates.class_id[idx];
+        const cv::Rect rect = _candidates.rect(idx);
+        pred.emplace_back(Prediction(id, rect.x, rect.y, rect.width, rect.height, _candidates.score[idx],
+                    id >= 0 && (size_t) id < _classes.size() ? _classes[id] : ""));
+    }
 }
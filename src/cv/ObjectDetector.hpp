@@ -1,9 +1,13 @@
 #ifndef __OBJECTDETECTOR_HPP
 #define __OBJECTDETECTOR_HPP
 
+#include <cstdint>
 #include <opencv2/core.hpp>
 #include <opencv2/dnn.hpp>
 #include <opencv2/imgproc.hpp>
+#include <Letterbox.hpp>
+#include <Candidates.hpp>
+#include <NMS.hpp>
 
 /***
  * Prediction class that is outputted by the
@@ -39,6 +43,14 @@ public:
 void drawPredictions(cv::Mat &frame, const std::vector<Prediction> &predictions, bool drawLabels=true,
                         const cv::Scalar &color=cv::Scalar(0, 0, 255), int thickness=1, int lineType=cv::LINE_8, int shift=0);
 
+/***
+ * scale the boxes of predictions, e.g. after the frame has been resized
+ * @param predictions
+ * @param fx horizontal scale factor
+ * @param fy vertical scale factor
+ */
+void scalePredictions(std::vector<Prediction> &predictions, double fx, double fy);
+
 /***
  * Wrapper class around OpenCV's DNN module to support
  * object detection models.
@@ -62,6 +74,7 @@ public:
 
     /***
      * read the getNetwork from the specified files
+     * Darknet, TensorFlow and Caffe files are memory mapped and parsed in place
      * @param model file containing the getNetwork parameters
      * @param config file containing the getNetwork architecture
      * @param framework the framwork that was used to make the mode
@@ -98,12 +111,34 @@ public:
 
     void setCrop(bool crop);
 
+    /***
+     * convert frames into the network input in a single pass that keeps the aspect ratio
+     * and pads the remaining area, instead of using cv::dnn::blobFromImage
+     * the network size must be set, crop is ignored and predictions are
+     * returned in the coordinates of the original frame
+     * @param letterbox
+     */
+    void setLetterbox(bool letterbox);
+
     void setDDepth(int ddepth);
 
     void setNMSThreshold(float nmsThreshold);
 
     void setConfidenceThreshold(float confThreshold);
 
+    /***
+     * keep only the k most confident predictions over all classes
+     * @param k 0 keeps all predictions
+     */
+    void setTopK(int k);
+
+    /***
+     * use Gaussian soft-NMS, which lowers the confidence of overlapping
+     * predictions instead of discarding them
+     * @param sigma 0 uses hard non-maximum suppression
+     */
+    void setSoftNMS(float sigma);
+
     void setClasses(const std::vector<std::string> &classes);
 
     /***
@@ -116,6 +151,14 @@ public:
      */
     std::vector<Prediction> run(const cv::Mat &frame);
 
+    /***
+     * run the detector on a blank frame, the first passes through a network are
+     * much slower than later ones as memory is allocated and layers are fused
+     * the size must be set before
+     * @param runs number of passes
+     */
+    void warmup(unsigned int runs);
+
     /***
      * get handle to the underlying cv::dnn::Net object
      * @return OpenCV's cv::dnn::Net
@@ -134,6 +177,24 @@ public:
      */
     float getNMSThreshold() const;
 
+    /***
+     * get the time preprocessing took in the last call to run in usec
+     * @return
+     */
+    uint64_t getPreprocessTime() const;
+
+    /***
+     * get the time the forward pass took in the last call to run in usec
+     * @return
+     */
+    uint64_t getForwardTime() const;
+
+    /***
+     * get the time postprocessing took in the last call to run in usec
+     * @return
+     */
+    uint64_t getPostprocessTime() const;
+
 private:
 
     void preprocess(const cv::Mat &frame);
@@ -142,6 +203,15 @@ private:
 
     std::vector<cv::String> _out_names;
 
+    // type of the output layer, selects how the output is decoded
+    std::string _out_layer_type;
+
+    // network takes the image size as additional input
+    bool _im_info = false;
+
+    // input blob if the letterbox is disabled
+    cv::Mat _blob;
+
     std::vector<std::string> _classes;
 
     cv::dnn::Net _net;
@@ -162,6 +232,25 @@ private:
 
     bool _crop = false;
 
+    bool _letterbox_enabled = false;
+
+    Letterbox _letterbox;
+
+    // decoded boxes, reused between frames
+    Candidates _candidates;
+
+    NMS _nms;
+
+    // indices of the candidates kept by the suppression
+    std::vector<int> _keep;
+
+    // durations of the stages of the last run in usec
+    uint64_t _preprocess_time = 0;
+
+    uint64_t _forward_time = 0;
+
+    uint64_t _postprocess_time = 0;
+
 };
 
 #endif // __OBJECTDETECTOR_HPP
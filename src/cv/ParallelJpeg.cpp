@@ -0,0 +1,220 @@
+#include <ParallelJpeg.hpp>
+#include <opencv2/imgproc.hpp>
+#include <cstdio>
+#include <csetjmp>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+#include <jpeglib.h>
+
+// markers of the JPEG bitstream
+static const unsigned char MARKER = 0xFF;
+static const unsigned char SOF0 = 0xC0;
+static const unsigned char SOF2 = 0xC2;
+static const unsigned char RST0 = 0xD0;
+static const unsigned char RST7 = 0xD7;
+static const unsigned char EOI = 0xD9;
+static const unsigned char SOS = 0xDA;
+
+// output of libjpeg goes straight into a vector that keeps its capacity between frames
+struct VectorDestination {
+    jpeg_destination_mgr pub;
+    std::vector<unsigned char> *buffer;
+};
+
+static void init_destination(j_compress_ptr cinfo) {
+    auto dest = reinterpret_cast<VectorDestination*>(cinfo->dest);
+    dest->buffer->resize(std::max(dest->buffer->capacity(), (size_t) 16384));
+    dest->pub.next_output_byte = dest->buffer->data();
+    dest->pub.free_in_buffer = dest->buffer->size();
+}
+
+static boolean empty_output_buffer(j_compress_ptr cinfo) {
+    auto dest = reinterpret_cast<VectorDestination*>(cinfo->dest);
+    const size_t size = dest->buffer->size();
+    dest->buffer->resize(2 * size);
+    dest->pub.next_output_byte = dest->buffer->data() + size;
+    dest->pub.free_in_buffer = dest->buffer->size() - size;
+    return TRUE;
+}
+
+static void term_destination(j_compress_ptr cinfo) {
+    auto dest = reinterpret_cast<VectorDestination*>(cinfo->dest);
+    dest->buffer->resize(dest->buffer->size() - dest->pub.free_in_buffer);
+}
+
+// libjpeg exits the process on errors by default, return to the caller instead
+struct ErrorManager {
+    jpeg_error_mgr pub;
+    jmp_buf jump;
+};
+
+static void error_exit(j_common_ptr cinfo) {
+    longjmp(reinterpret_cast<ErrorManager*>(cinfo->err)->jump, 1);
+}
+
+static void output_message(j_common_ptr) {
+    // warnings are ignored
+}
+
+/***
+ * find the entropy coded data of a JPEG image produced by libjpeg
+ * @param data
+ * @param begin first byte after the SOS segment
+ * @param end position of the EOI marker
+ * @param sof position of the SOF marker
+ */
+static void find_scan(const std::vector<unsigned char> &data, size_t &begin, size_t &end, size_t &sof) {
+    size_t pos = 2;
+    sof = 0;
+    while (pos + 4 <= data.size() && data[pos] == MARKER) {
+        const unsigned char marker = data[pos + 1];
+        const size_t length = ((size_t) data[pos + 2] << 8) | data[pos + 3];
+        if (marker >= SOF0 && marker <= SOF2) {
+            sof = pos;
+        } else if (marker == SOS) {
+            begin = pos + 2 + length;
+            end = data.size() - 2;
+            if (sof == 0 || begin > end || data[end] != MARKER || data[end + 1] != EOI) {
+                break;
+            }
+            return;
+        }
+        pos += 2 + length;
+    }
+    throw std::runtime_error("malformed JPEG strip");
+}
+
+ParallelJpegEncoder::ParallelJpegEncoder(unsigned int strips) :
+        _strips(strips) {}
+
+void ParallelJpegEncoder::setStrips(unsigned int strips) {
+    _strips = strips;
+}
+
+unsigned int ParallelJpegEncoder::strips() const {
+    return _strips > 0 ? _strips : (unsigned int) std::max(1, cv::getNumThreads());
+}
+
+bool ParallelJpegEncoder::encodeStrip(const cv::Mat &strip, int quality, std::vector<unsigned char> &buffer) {
+    jpeg_compress_struct cinfo;
+    ErrorManager err;
+    cinfo.err = jpeg_std_error(&err.pub);
+    err.pub.error_exit = error_exit;
+    err.pub.output_message = output_message;
+    if (setjmp(err.jump)) {
+        jpeg_destroy_compress(&cinfo);
+        return false;
+    }
+    jpeg_create_compress(&cinfo);
+
+    VectorDestination dest;
+    dest.pub.init_destination = init_destination;
+    dest.pub.empty_output_buffer = empty_output_buffer;
+    dest.pub.term_destination = term_destination;
+    dest.buffer = &buffer;
+    cinfo.dest = &dest.pub;
+
+    cinfo.image_width = (JDIMENSION) strip.cols;
+    cinfo.image_height = (JDIMENSION) strip.rows;
+    cinfo.input_components = strip.channels();
+#ifdef JCS_EXTENSIONS
+    cinfo.in_color_space = strip.channels() == 3 ? JCS_EXT_BGR : JCS_GRAYSCALE;
+#else
+    cinfo.in_color_space = strip.channels() == 3 ? JCS_RGB : JCS_GRAYSCALE;
+#endif
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    // the strips only fit together with the standard Huffman tables
+    cinfo.optimize_coding = FALSE;
+    cinfo.restart_in_rows = 1;
+
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = const_cast<JSAMPROW>(strip.ptr(cinfo.next_scanline));
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    return true;
+}
+
+void ParallelJpegEncoder::encode(const cv::Mat &frame, int quality, std::vector<unsigned char> &buffer) {
+    CV_Assert(!frame.empty() && frame.depth() == CV_8U && (frame.channels() == 3 || frame.channels() == 1));
+    CV_Assert(0 <= quality && quality <= 100);
+#ifdef JCS_EXTENSIONS
+    const cv::Mat &image = frame;
+#else
+    cv::Mat image = frame;
+    if (frame.channels() == 3) {
+        cv::cvtColor(frame, image, cv::COLOR_BGR2RGB);
+    }
+#endif
+
+    // color is subsampled by 2 in both directions, an MCU is 16 rows high then
+    const int mcu_height = image.channels() == 3 ? 16 : 8;
+    const int mcu_rows = (image.rows + mcu_height - 1) / mcu_height;
+    const int count = std::min((int) strips(), mcu_rows);
+    const int strip_mcu_rows = (mcu_rows + count - 1) / count;
+    const int strip_rows = strip_mcu_rows * mcu_height;
+    const int num_strips = (mcu_rows + strip_mcu_rows - 1) / strip_mcu_rows;
+    _buffers.resize((size_t) num_strips);
+
+    std::atomic_bool failed { false };
+    cv::parallel_for_(cv::Range(0, num_strips), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; ++i) {
+            const int top = i * strip_rows;
+            const int bottom = std::min(top + strip_rows, image.rows);
+            if (!encodeStrip(image.rowRange(top, bottom), quality, _buffers[i])) {
+                failed = true;
+            }
+        }
+    });
+    if (failed) {
+        throw std::runtime_error("JPEG encoding failed");
+    }
+
+    if (num_strips == 1) {
+        // keep the capacity of the caller's buffer for the next frame
+        std::swap(buffer, _buffers[0]);
+        return;
+    }
+
+    // header of the first strip with the height of the whole frame
+    size_t begin, end, sof;
+    find_scan(_buffers[0], begin, end, sof);
+    buffer.assign(_buffers[0].begin(), _buffers[0].begin() + begin);
+    buffer[sof + 5] = (unsigned char) (image.rows >> 8);
+    buffer[sof + 6] = (unsigned char) (image.rows & 0xFF);
+
+    // scans one after another, restart markers are counted through the whole frame
+    unsigned int restart = 0;
+    for (int i = 0; i < num_strips; ++i) {
+        const std::vector<unsigned char> &strip = _buffers[i];
+        if (i > 0) {
+            find_scan(strip, begin, end, sof);
+            buffer.push_back(MARKER);
+            buffer.push_back((unsigned char) (RST0 + (restart++ & 7)));
+        }
+        // stuffed 0xFF bytes are followed by 0x00, restart markers by RST0 to RST7
+        const unsigned char *src = strip.data() + begin;
+        const unsigned char *const last = strip.data() + end;
+        while (src < last) {
+            auto next = static_cast<const unsigned char*>(std::memchr(src, MARKER, (size_t) (last - src)));
+            if (next == nullptr || next + 1 >= last) {
+                buffer.insert(buffer.end(), src, last);
+                break;
+            }
+            buffer.insert(buffer.end(), src, next + 1);
+            if (next[1] >= RST0 && next[1] <= RST7) {
+                buffer.push_back((unsigned char) (RST0 + (restart++ & 7)));
+            } else {
+                buffer.push_back(next[1]);
+            }
+            src = next + 2;
+        }
+    }
+    buffer.push_back(MARKER);
+    buffer.push_back(EOI);
+}
@@ -0,0 +1,65 @@
+#ifndef __PARALLELJPEG_HPP
+#define __PARALLELJPEG_HPP
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+/***
+ * JPEG encoder that spreads the work over several cores.
+ * The frame is split into horizontal strips whose height is a multiple of
+ * the MCU height and every strip is compressed on its own with libjpeg,
+ * using the same tables and a restart marker after every row of MCUs.
+ * As a restart resets the DC prediction of the entropy coder, the scans of
+ * the strips can simply be put one after another, separated by a further
+ * restart marker. With the restart markers renumbered, the result is the
+ * very bitstream a single encoder with the same restart interval produces,
+ * so any JPEG decoder reads it.
+ * The strips are encoded with cv::parallel_for_ on OpenCV's thread pool.
+ */
+class ParallelJpegEncoder {
+public:
+
+    /***
+     * create encoder
+     * @param strips number of strips a frame is split into, 0 uses one per thread of OpenCV's pool
+     */
+    explicit ParallelJpegEncoder(unsigned int strips=0);
+
+    /***
+     * set the number of strips a frame is split into
+     * @param strips 0 uses one per thread of OpenCV's pool
+     */
+    void setStrips(unsigned int strips);
+
+    /***
+     * get the number of strips a frame is split into
+     * @return
+     */
+    unsigned int strips() const;
+
+    /***
+     * compress a frame
+     * @param frame 8 bit BGR or grayscale image
+     * @param quality JPEG quality in [0, 100]
+     * @param buffer JPEG data
+     */
+    void encode(const cv::Mat &frame, int quality, std::vector<unsigned char> &buffer);
+
+private:
+
+    /***
+     * compress a strip of the frame into a complete JPEG image
+     * @param strip
+     * @param quality
+     * @param buffer
+     * @return false if libjpeg has failed
+     */
+    static bool encodeStrip(const cv::Mat &strip, int quality, std::vector<unsigned char> &buffer);
+
+    unsigned int _strips = 0;
+
+    std::vector<std::vector<unsigned char>> _buffers;
+
+};
+
+#endif // __PARALLELJPEG_HPP
@@ -0,0 +1,145 @@
+#include <QualityController.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <cmath>
+#include <sys/ioctl.h>
+#ifdef __linux__
+#include <linux/sockios.h>
+#endif
+
+// every resolution level scales both dimensions by this factor
+static const double LEVEL_FACTOR = std::sqrt(0.5);
+
+void QualityController::setTargetLatency(double ms) {
+    CV_Assert(ms > 0.0);
+    _target = ms;
+}
+
+void QualityController::setQualityRange(int min, int max) {
+    CV_Assert(0 <= min && min <= max && max <= 100);
+    _min_quality = min;
+    _max_quality = max;
+    _quality = max;
+}
+
+void QualityController::setMinScale(double scale) {
+    CV_Assert(scale > 0.0 && scale <= 1.0);
+    _max_level = (int) std::floor(std::log(scale) / std::log(LEVEL_FACTOR) + 1e-6);
+    _level = std::min((int) _level, _max_level);
+}
+
+void QualityController::setStrips(unsigned int strips) {
+    _strips = strips;
+    _jpeg.setStrips(strips);
+}
+
+cv::Size QualityController::encode(const cv::Mat &frame, std::vector<unsigned char> &buffer) {
+    CV_Assert(!frame.empty());
+    const cv::Mat *image = &frame;
+    const double s = scale();
+    const int quality = _quality;
+    if (s < 1.0) {
+        cv::resize(frame, _scaled, cv::Size(), s, s, cv::INTER_AREA);
+        image = &_scaled;
+    }
+
+    if (_strips != 1) {
+        _jpeg.encode(*image, quality, buffer);
+    } else {
+        _params.assign({ cv::IMWRITE_JPEG_QUALITY, quality });
+        cv::imencode(".jpeg", *image, buffer, _params);
+    }
+    _encoded_size = cv::Size(image->cols, image->rows);
+    _encoded_quality = quality;
+    return _encoded_size;
+}
+
+void QualityController::update(size_t bytes, uint64_t send_time, long queued) {
+    const auto now = std::chrono::steady_clock::now();
+
+    // bytes the link has drained since the last frame
+    if (queued >= 0 && !_first) {
+        const double elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - _last_update).count();
+        const double drained = (double) _last_queued + (double) bytes - (double) queued;
+        if (elapsed > 0.0 && drained > 0.0) {
+            const double rate = drained / elapsed;
+            _rate = _rate > 0.0 ? 0.8 * _rate + 0.2 * rate : rate;
+        }
+    }
+
+    // time until the frame has left the host, queued bytes go out at the link rate
+    double latency = (double) send_time / 1000.0;
+    if (queued > 0 && _rate > 0.0) {
+        latency += (double) queued / _rate * 1000.0;
+    }
+    _latency = _first ? latency : 0.7 * _latency + 0.3 * latency;
+
+    _last_update = now;
+    _last_queued = std::max(queued, 0L);
+    _first = false;
+
+    // give the last change time to show in the latency before changing again
+    if (now - _last_change < std::chrono::microseconds((int64_t) (_target * 1000.0))) {
+        return;
+    }
+    if (_latency > _target) {
+        decrease();
+        _last_change = now;
+    } else if (_latency < 0.5 * _target) {
+        increase();
+        _last_change = now;
+    }
+}
+
+int QualityController::quality() const {
+    return _quality;
+}
+
+cv::Size QualityController::encodedSize() const {
+    return _encoded_size;
+}
+
+int QualityController::encodedQuality() const {
+    return _encoded_quality;
+}
+
+double QualityController::scale() const {
+    return std::pow(LEVEL_FACTOR, (int) _level);
+}
+
+double QualityController::latency() const {
+    return _latency;
+}
+
+double QualityController::rate() const {
+    return _rate;
+}
+
+long QualityController::queued(int fd) {
+#ifdef __linux__
+    int value = 0;
+    if (::ioctl(fd, SIOCOUTQ, &value) == 0) {
+        return value;
+    }
+#endif
+    return -1;
+}
+
+void QualityController::decrease() {
+    if (_quality > _min_quality) {
+        _quality = std::max(_min_quality, (int) (_quality * 0.8));
+    } else if (_level < _max_level) {
+        // halve the pixel count, the quality can recover at the lower resolution
+        _level += 1;
+        _quality = (_min_quality + _max_quality) / 2;
+    }
+}
+
+void QualityController::increase() {
+    if (_level > 0) {
+        _level -= 1;
+    } else if (_quality < _max_quality) {
+        _quality = std::min(_max_quality, _quality + 2);
+    }
+}
@@ -0,0 +1,167 @@
+#ifndef __QUALITYCONTROLLER_HPP
+#define __QUALITYCONTROLLER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <opencv2/core.hpp>
+#include <ParallelJpeg.hpp>
+
+/***
+ * Feedback controller that adapts JPEG quality and resolution of a video
+ * stream to the throughput of the link, so that the latency stays below a target
+ * instead of growing with the socket's send queue.
+ * After every frame it is told how long sending took and how many bytes are
+ * still queued in the socket (SIOCOUTQ). From the bytes the link has drained
+ * between two frames it estimates the link rate and with it the time the
+ * newest frame waits until it is on the wire.
+ * Above the target latency the quality is reduced multiplicatively and once it
+ * is at its minimum, the resolution is reduced in steps of half the pixel count.
+ * Well below the target, first the resolution and then the quality are raised again
+ * one step at a time. After every change the controller waits for the target
+ * latency before it changes the parameters again.
+ * encode() and update() may be called from different threads, e.g. the encode
+ * and the send stage of a pipeline, but each only from one.
+ */
+class QualityController {
+public:
+
+    QualityController() = default;
+
+    /***
+     * set the latency the controller aims for
+     * @param ms
+     */
+    void setTargetLatency(double ms);
+
+    /***
+     * set the range of the JPEG quality
+     * @param min
+     * @param max at most 100, the quality starts at this value
+     */
+    void setQualityRange(int min, int max);
+
+    /***
+     * set the smallest factor the frames are scaled with
+     * @param scale in (0, 1], 1 keeps the resolution fixed
+     */
+    void setMinScale(double scale);
+
+    /***
+     * split the frames into strips that are compressed in parallel
+     * @param strips 0 uses one per core, 1 compresses the whole frame on the calling thread
+     */
+    void setStrips(unsigned int strips);
+
+    /***
+     * scale the frame and compress it with the current parameters
+     * @param frame
+     * @param buffer JPEG data
+     * @return size of the encoded image
+     */
+    cv::Size encode(const cv::Mat &frame, std::vector<unsigned char> &buffer);
+
+    /***
+     * feed back the result of sending a frame
+     * @param bytes number of bytes that have been sent
+     * @param send_time time the send call took in usec
+     * @param queued number of bytes still in the socket's send queue, negative if unknown
+     */
+    void update(size_t bytes, uint64_t send_time, long queued);
+
+    /***
+     * get the current JPEG quality
+     * @return
+     */
+    int quality() const;
+
+    /***
+     * get the size of the last encoded image
+     * @return
+     */
+    cv::Size encodedSize() const;
+
+    /***
+     * get the JPEG quality the last image has been encoded with, the current one
+     * may have changed since by feedback from another thread
+     * @return
+     */
+    int encodedQuality() const;
+
+    /***
+     * get the current scale factor
+     * @return
+     */
+    double scale() const;
+
+    /***
+     * get the estimated latency of the last frame in ms
+     * @return
+     */
+    double latency() const;
+
+    /***
+     * get the estimated link rate in bytes per second
+     * @return
+     */
+    double rate() const;
+
+    /***
+     * get the number of bytes in the send queue of a socket
+     * @param fd socket descriptor
+     * @return -1 if it cannot be determined
+     */
+    static long queued(int fd);
+
+private:
+
+    void decrease();
+
+    void increase();
+
+    double _target = 100.0;
+
+    int _min_quality = 30;
+
+    int _max_quality = 90;
+
+    std::atomic_int _quality { 90 };
+
+    // resolution level, every level halves the pixel count
+    std::atomic_int _level { 0 };
+
+    int _max_level = 0;
+
+    // smoothed link rate in bytes per sec
+    double _rate = 0.0;
+
+    double _latency = 0.0;
+
+    // state of the last update
+    std::chrono::steady_clock::time_point _last_update;
+
+    long _last_queued = 0;
+
+    // time the parameters have last been changed
+    std::chrono::steady_clock::time_point _last_change;
+
+    bool _first = true;
+
+    cv::Mat _scaled;
+
+    unsigned int _strips = 1;
+
+    ParallelJpegEncoder _jpeg;
+
+    std::vector<int> _params;
+
+    // parameters of the last encoded image, only used by the encoding thread
+    cv::Size _encoded_size;
+
+    int _encoded_quality = 0;
+
+};
+
+#endif // __QUALITYCONTROLLER_HPP
@@ -0,0 +1,77 @@
+#include <RegionDecoder.hpp>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+int argmax(const float *data, int n, float &max) {
+    int i = 0;
+    float m = data[0];
+
+#if defined(__SSE2__)
+    if (n >= 4) {
+        __m128 vmax = _mm_loadu_ps(data);
+        for (i = 4; i + 4 <= n; i += 4) {
+            vmax = _mm_max_ps(vmax, _mm_loadu_ps(data + i));
+        }
+        // horizontal maximum of the four lanes
+        vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+        vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+        m = _mm_cvtss_f32(vmax);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (n >= 4) {
+        float32x4_t vmax = vld1q_f32(data);
+        for (i = 4; i + 4 <= n; i += 4) {
+            vmax = vmaxq_f32(vmax, vld1q_f32(data + i));
+        }
+        // horizontal maximum of the four lanes
+        float32x2_t pmax = vpmax_f32(vget_low_f32(vmax), vget_high_f32(vmax));
+        pmax = vpmax_f32(pmax, pmax);
+        m = vget_lane_f32(pmax, 0);
+    }
+#endif
+
+    // remaining elements
+    for (; i < n; ++i) {
+        m = data[i] > m ? data[i] : m;
+    }
+
+    // the maximum is known, find its first occurrence
+    // a NaN score makes the maximum NaN, which equals no element, the first one is taken then
+    int index = 0;
+    while (index < n && data[index] != m) {
+        ++index;
+    }
+    if (index == n) {
+        index = 0;
+    }
+    max = data[index];
+    return index;
+}
+
+void decodeRegion(const cv::Mat &out, const cv::Size &size, float threshold, Candidates &candidates) {
+    CV_Assert(out.dims == 2 && out.cols > 5 && out.depth() == CV_32F);
+    const int classes = out.cols - 5;
+    const auto width = (float) size.width;
+    const auto height = (float) size.height;
+
+    for (int j = 0; j < out.rows; ++j) {
+        const float *row = out.ptr<float>(j);
+        // class scores are scaled by the objectness, so they cannot exceed it
+        if (row[4] <= threshold) {
+            continue;
+        }
+
+        float score;
+        const int id = argmax(row + 5, classes, score);
+        if (score > threshold) {
+            const float half_width = row[2] * 0.5f;
+            const float half_height = row[3] * 0.5f;
+            candidates.push_back((row[0] - half_width) * width, (row[1] - half_height) * height,
+                                 (row[0] + half_width) * width, (row[1] + half_height) * height, score, id);
+        }
+    }
+}
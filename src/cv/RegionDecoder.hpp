@@ -0,0 +1,32 @@
+#ifndef __REGIONDECODER_HPP
+#define __REGIONDECODER_HPP
+
+#include <opencv2/core.hpp>
+#include <Candidates.hpp>
+
+/***
+ * get index and value of the largest element, the search is vectorized
+ * with SSE or NEON where available
+ * @param data
+ * @param n number of elements, must be at least 1
+ * @param max set to the largest value
+ * @return index of the first occurrence of the largest value, 0 if the data contains NaN
+ *          and no largest value can be found
+ */
+int argmax(const float *data, int n, float &max);
+
+/***
+ * decode the output of a YOLO Region layer
+ * The blob has a shape NxC where N is the number of candidate boxes and C is
+ * the number of classes + 5 with each row [center_x, center_y, width, height,
+ * objectness, class scores...]. As the class scores are already scaled by the
+ * objectness, rows whose objectness is below the threshold are rejected
+ * before their class scores are looked at.
+ * @param out output blob of the Region layer
+ * @param size network input size the normalized coordinates are scaled with
+ * @param threshold confidence threshold
+ * @param candidates boxes above the threshold are appended
+ */
+void decodeRegion(const cv::Mat &out, const cv::Size &size, float threshold, Candidates &candidates);
+
+#endif // __REGIONDECODER_HPP
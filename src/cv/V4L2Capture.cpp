@@ -0,0 +1,244 @@
+#include <V4L2Capture.hpp>
+#include <common.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <stdexcept>
+
+// wrapper around syscalls with same name as member functions
+static int _open(const char *fname, int mode) {
+    return open(fname, mode);
+}
+
+static int _close(int fd) {
+    return close(fd);
+}
+
+// ioctl that is restarted if interrupted by a signal
+static int _ioctl(int fd, unsigned long request, void *arg) {
+    int r;
+    do {
+        r = ioctl(fd, request, arg);
+    } while (r == -1 && errno == EINTR);
+    return r;
+}
+
+V4L2Capture::pixel_format_t V4L2Capture::format_from_string(const std::string &str) {
+    if (string::iequals(str, "YUYV")) {
+        return YUYV;
+    } else if (string::iequals(str, "MJPEG") || string::iequals(str, "MJPG")) {
+        return MJPEG;
+    } else {
+        throw std::invalid_argument("unsupported pixel format \'" + str + '\'');
+    }
+}
+
+V4L2Capture::V4L2Capture(const std::string &device, int width, int height, pixel_format_t format, unsigned int buffers) {
+    open(device, width, height, format, buffers);
+}
+
+V4L2Capture::~V4L2Capture() {
+    close();
+}
+
+void V4L2Capture::open(const std::string &device, int width, int height, pixel_format_t format, unsigned int buffers) {
+    close();
+
+    _fd = _open(device.c_str(), O_RDWR | O_NONBLOCK);
+    if (_fd < 0) {
+        throw std::runtime_error("cannot open video device \'" + device + '\'');
+    }
+
+    struct v4l2_capability cap = { 0 };
+    if (_ioctl(_fd, VIDIOC_QUERYCAP, &cap) < 0) {
+        close();
+        throw std::runtime_error("\'" + device + "\' is not a V4L2 device");
+    }
+    const uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+        close();
+        throw std::runtime_error("\'" + device + "\' does not support streaming capture");
+    }
+
+    // negotiate format, the driver adjusts the size to the closest one it supports
+    struct v4l2_format fmt = { 0 };
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = (uint32_t) width;
+    fmt.fmt.pix.height = (uint32_t) height;
+    fmt.fmt.pix.pixelformat = format;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if (_ioctl(_fd, VIDIOC_S_FMT, &fmt) < 0 || fmt.fmt.pix.pixelformat != (uint32_t) format) {
+        close();
+        throw std::runtime_error("cannot set video format");
+    }
+    _width = (int) fmt.fmt.pix.width;
+    _height = (int) fmt.fmt.pix.height;
+    _stride = fmt.fmt.pix.bytesperline != 0 ? fmt.fmt.pix.bytesperline : fmt.fmt.pix.width * 2;
+    _format = format;
+
+    // request and map streaming buffers
+    struct v4l2_requestbuffers req = { 0 };
+    req.count = buffers;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (_ioctl(_fd, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+        close();
+        throw std::runtime_error("cannot allocate video buffers");
+    }
+
+    _buffers.resize(req.count);
+    for (uint32_t i = 0; i < req.count; ++i) {
+        struct v4l2_buffer buf = { 0 };
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (_ioctl(_fd, VIDIOC_QUERYBUF, &buf) < 0) {
+            close();
+            throw std::runtime_error("cannot query video buffer");
+        }
+
+        void *start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, buf.m.offset);
+        if (start == MAP_FAILED) {
+            close();
+            throw std::runtime_error("cannot map video buffer");
+        }
+        _buffers[i].start = start;
+        _buffers[i].length = buf.length;
+
+        if (_ioctl(_fd, VIDIOC_QBUF, &buf) < 0) {
+            close();
+            throw std::runtime_error("cannot queue video buffer");
+        }
+    }
+
+    enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (_ioctl(_fd, VIDIOC_STREAMON, &type) < 0) {
+        close();
+        throw std::runtime_error("cannot start streaming");
+    }
+    _streaming = true;
+}
+
+bool V4L2Capture::dequeue(V4L2Capture::Buffer &buffer, int timeout) {
+    if (!_streaming) {
+        throw std::runtime_error("device not streaming");
+    }
+
+    struct pollfd pfd = { _fd, POLLIN, 0 };
+    if (poll(&pfd, 1, timeout) <= 0) {
+        return false;
+    }
+
+    struct v4l2_buffer buf = { 0 };
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (_ioctl(_fd, VIDIOC_DQBUF, &buf) < 0) {
+        if (errno == EAGAIN) {
+            return false;
+        }
+        throw std::runtime_error("cannot dequeue video buffer");
+    }
+
+    void *start = _buffers[buf.index].start;
+    buffer.index = (int) buf.index;
+    buffer.sequence = buf.sequence;
+    if (_format == YUYV) {
+        buffer.data = cv::Mat(_height, _width, CV_8UC2, start, _stride);
+    } else {
+        buffer.data = cv::Mat(1, (int) buf.bytesused, CV_8UC1, start);
+    }
+
+    // monotonic driver timestamps share their epoch with std::chrono::steady_clock
+    if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+        buffer.timestamp = std::chrono::steady_clock::time_point(
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::seconds(buf.timestamp.tv_sec) + std::chrono::microseconds(buf.timestamp.tv_usec)));
+    } else {
+        buffer.timestamp = std::chrono::steady_clock::now();
+    }
+    return true;
+}
+
+void V4L2Capture::requeue(V4L2Capture::Buffer &buffer) {
+    if (buffer.index < 0) {
+        return;
+    }
+
+    struct v4l2_buffer buf = { 0 };
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = (uint32_t) buffer.index;
+    buffer.index = -1;
+    buffer.data = cv::Mat();
+    if (_ioctl(_fd, VIDIOC_QBUF, &buf) < 0) {
+        throw std::runtime_error("cannot queue video buffer");
+    }
+}
+
+void V4L2Capture::retrieve(const V4L2Capture::Buffer &buffer, cv::Mat &frame) const {
+    CV_Assert(buffer.index >= 0 && !buffer.data.empty());
+    if (_format == YUYV) {
+        cv::cvtColor(buffer.data, frame, cv::COLOR_YUV2BGR_YUYV);
+    } else {
+        cv::imdecode(buffer.data, cv::IMREAD_COLOR, &frame);
+    }
+}
+
+void V4L2Capture::close() {
+    if (_streaming) {
+        enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        _ioctl(_fd, VIDIOC_STREAMOFF, &type);
+        _streaming = false;
+    }
+
+    for (auto &mapping : _buffers) {
+        if (mapping.start != nullptr) {
+            munmap(mapping.start, mapping.length);
+        }
+    }
+
+    if (!_buffers.empty()) {
+        struct v4l2_requestbuffers req = { 0 };
+        req.count = 0;
+        req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        req.memory = V4L2_MEMORY_MMAP;
+        _ioctl(_fd, VIDIOC_REQBUFS, &req);
+        _buffers.clear();
+    }
+
+    if (_fd >= 0) {
+        _close(_fd);
+        _fd = -1;
+    }
+}
+
+bool V4L2Capture::isOpened() const {
+    return _streaming;
+}
+
+int V4L2Capture::width() const {
+    return _width;
+}
+
+int V4L2Capture::height() const {
+    return _height;
+}
+
+V4L2Capture::pixel_format_t V4L2Capture::format() const {
+    return _format;
+}
+
+double V4L2Capture::fps() const {
+    struct v4l2_streamparm parm = { 0 };
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (_fd < 0 || _ioctl(_fd, VIDIOC_G_PARM, &parm) < 0 || parm.parm.capture.timeperframe.numerator == 0) {
+        return 0.0;
+    }
+    return double(parm.parm.capture.timeperframe.denominator) / double(parm.parm.capture.timeperframe.numerator);
+}
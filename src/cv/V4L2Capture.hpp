@@ -0,0 +1,145 @@
+#ifndef __V4L2CAPTURE_HPP
+#define __V4L2CAPTURE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <opencv2/core.hpp>
+#include <linux/videodev2.h>
+
+/***
+ * Native V4L2 capture device using memory mapped streaming buffers.
+ * Dequeued buffers are handed out as cv::Mat headers that point directly
+ * into the driver's memory, nothing is copied until the image is converted.
+ * Every dequeued buffer must be given back with requeue() once it is no
+ * longer needed, otherwise the driver runs out of buffers.
+ * Any V4L2 capture device can be used, e.g. the virtual vivid device for testing.
+ */
+class V4L2Capture {
+public:
+
+    // supported pixel formats
+    enum pixel_format_t {
+        YUYV = V4L2_PIX_FMT_YUYV,
+        MJPEG = V4L2_PIX_FMT_MJPEG
+    };
+
+    /***
+     * parse pixel format from its name, ignoring case
+     * @param str either YUYV or MJPEG
+     * @return
+     */
+    static pixel_format_t format_from_string(const std::string &str);
+
+    /***
+     * dequeued driver buffer
+     */
+    struct Buffer {
+
+        // driver buffer index, needed for requeue
+        int index = -1;
+
+        // YUYV: height x width CV_8UC2, MJPEG: 1 x bytesused CV_8UC1
+        // only valid until the buffer has been requeued
+        cv::Mat data;
+
+        // frame counter maintained by the driver
+        uint32_t sequence = 0;
+
+        // time the frame has been captured
+        std::chrono::steady_clock::time_point timestamp;
+
+    };
+
+    /// default constructor
+    V4L2Capture() = default;
+
+    /// constructor, wrapper around open
+    V4L2Capture(const std::string &device, int width, int height, pixel_format_t format=YUYV, unsigned int buffers=4);
+
+    V4L2Capture(const V4L2Capture &capture) = delete;
+
+    /// destructor
+    ~V4L2Capture();
+
+    V4L2Capture& operator=(const V4L2Capture &capture) = delete;
+
+    /***
+     * open device, negotiate the format, map the streaming buffers and start streaming
+     * the driver may adjust width and height to the closest supported size
+     * @param device path to the device node, e.g. /dev/video0
+     * @param width requested frame width
+     * @param height requested frame height
+     * @param format requested pixel format
+     * @param buffers number of buffers to request from the driver
+     */
+    void open(const std::string &device, int width, int height, pixel_format_t format=YUYV, unsigned int buffers=4);
+
+    /***
+     * wait for the next filled buffer
+     * @param buffer
+     * @param timeout in msec, negative values wait forever
+     * @return false if no buffer has been filled within the timeout
+     */
+    bool dequeue(Buffer &buffer, int timeout=-1);
+
+    /***
+     * hand buffer back to the driver, its data must not be accessed afterwards
+     * @param buffer
+     */
+    void requeue(Buffer &buffer);
+
+    /***
+     * convert buffer to a BGR image, reading directly from the driver's memory
+     * @param buffer
+     * @param frame
+     */
+    void retrieve(const Buffer &buffer, cv::Mat &frame) const;
+
+    /***
+     * stop streaming, unmap buffers and close the device
+     */
+    void close();
+
+    bool isOpened() const;
+
+    int width() const;
+
+    int height() const;
+
+    pixel_format_t format() const;
+
+    /***
+     * get the frame rate reported by the driver, 0 if unknown
+     * @return
+     */
+    double fps() const;
+
+private:
+
+    struct Mapping {
+
+        void *start = nullptr;
+
+        size_t length = 0;
+
+    };
+
+    int _fd = -1; // file descriptor
+
+    std::vector<Mapping> _buffers; // memory mapped driver buffers
+
+    int _width = 0;
+
+    int _height = 0;
+
+    size_t _stride = 0; // bytes per line
+
+    pixel_format_t _format = YUYV;
+
+    bool _streaming = false;
+
+};
+
+#endif // __V4L2CAPTURE_HPP
@@ -0,0 +1,85 @@
+#include <VideoCodec.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <common.hpp>
+#include <stdexcept>
+#ifdef WITH_VPX
+#include <Vp8Codec.hpp>
+#endif
+
+VideoEncoder::codec_t VideoEncoder::codec_from_string(const std::string &str) {
+    if (string::iequals(str, "JPEG")) {
+        return JPEG;
+    } else if (string::iequals(str, "VP8")) {
+        return VP8;
+    } else {
+        throw std::invalid_argument("unknown video codec '" + str + "'");
+    }
+}
+
+bool VideoEncoder::available(VideoEncoder::codec_t codec) {
+#ifdef WITH_VPX
+    return codec == JPEG || codec == VP8;
+#else
+    return codec == JPEG;
+#endif
+}
+
+std::unique_ptr<VideoEncoder> VideoEncoder::create(VideoEncoder::codec_t codec, QualityController &quality,
+                                                   unsigned int bitrate) {
+    switch (codec) {
+        case JPEG:
+            return std::unique_ptr<VideoEncoder>(new JpegEncoder(quality));
+#ifdef WITH_VPX
+        case VP8:
+            return std::unique_ptr<VideoEncoder>(new Vp8Encoder(bitrate));
+#endif
+        default:
+            throw std::runtime_error("video codec not available");
+    }
+}
+
+std::unique_ptr<VideoDecoder> VideoDecoder::create(VideoEncoder::codec_t codec) {
+    switch (codec) {
+        case VideoEncoder::JPEG:
+            return std::unique_ptr<VideoDecoder>(new JpegDecoder);
+#ifdef WITH_VPX
+        case VideoEncoder::VP8:
+            return std::unique_ptr<VideoDecoder>(new Vp8Decoder);
+#endif
+        default:
+            throw std::runtime_error("video codec not available");
+    }
+}
+
+JpegEncoder::JpegEncoder(QualityController &quality) :
+        _quality(quality) {}
+
+VideoEncoder::codec_t JpegEncoder::codec() const {
+    return JPEG;
+}
+
+void JpegEncoder::encode(const cv::Mat &frame, std::vector<unsigned char> &buffer) {
+    _quality.encode(frame, buffer);
+}
+
+void JpegEncoder::requestKeyframe() {
+    // every frame is a keyframe
+}
+
+bool JpegEncoder::keyframe() const {
+    return true;
+}
+
+cv::Size JpegEncoder::size() const {
+    // the quality controller scales frames down to hold the target latency
+    return _quality.encodedSize();
+}
+
+bool JpegDecoder::decode(const std::vector<unsigned char> &data, cv::Mat &frame) {
+    cv::imdecode(data, cv::IMREAD_COLOR, &frame);
+    return !frame.empty();
+}
+
+void JpegDecoder::reset() {
+    // every frame is decoded on its own
+}
@@ -0,0 +1,144 @@
+#ifndef __VIDEOCODEC_HPP
+#define __VIDEOCODEC_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <opencv2/core.hpp>
+#include <QualityController.hpp>
+
+/***
+ * Compresses the frames of a video stream. Intra-frame codecs like JPEG
+ * encode every frame on its own, inter-frame codecs only encode what has
+ * changed since the previous frame and need a keyframe to start decoding
+ * from, e.g. when a client joins or has lost frames.
+ */
+class VideoEncoder {
+public:
+
+    enum codec_t {
+        JPEG = 0,
+        VP8
+    };
+
+    /***
+     * get the codec from a string, "JPEG" or "VP8"
+     * @param str
+     * @return
+     */
+    static codec_t codec_from_string(const std::string &str);
+
+    /***
+     * check if support for a codec has been compiled in
+     * @param codec
+     * @return
+     */
+    static bool available(codec_t codec);
+
+    /***
+     * create encoder for a codec
+     * @param codec
+     * @param quality sets the parameters of JPEG
+     * @param bitrate target bitrate in kbit/s of inter-frame codecs
+     * @return
+     */
+    static std::unique_ptr<VideoEncoder> create(codec_t codec, QualityController &quality, unsigned int bitrate=1000);
+
+    virtual ~VideoEncoder() = default;
+
+    virtual codec_t codec() const = 0;
+
+    /***
+     * encode a frame
+     * @param frame BGR image
+     * @param buffer overwritten with the compressed frame
+     */
+    virtual void encode(const cv::Mat &frame, std::vector<unsigned char> &buffer) = 0;
+
+    /***
+     * make the next frame a keyframe
+     */
+    virtual void requestKeyframe() = 0;
+
+    /***
+     * check if the last encoded frame is a keyframe, decoding can start with it
+     * @return
+     */
+    virtual bool keyframe() const = 0;
+
+    /***
+     * get the size the last frame has been scaled to before encoding, predictions
+     * are sent in its coordinates
+     * @return
+     */
+    virtual cv::Size size() const = 0;
+
+};
+
+/***
+ * Decompresses the frames of a video stream.
+ */
+class VideoDecoder {
+public:
+
+    /***
+     * create decoder for a codec
+     * @param codec
+     * @return
+     */
+    static std::unique_ptr<VideoDecoder> create(VideoEncoder::codec_t codec);
+
+    virtual ~VideoDecoder() = default;
+
+    /***
+     * decode a frame
+     * @param data compressed frame
+     * @param frame BGR image
+     * @return false if the frame cannot be decoded, e.g. because a previous frame
+     *          has been lost, a keyframe has to be requested then
+     */
+    virtual bool decode(const std::vector<unsigned char> &data, cv::Mat &frame) = 0;
+
+    /***
+     * drop the reference frames after a frame has been lost, inter-frame codecs do not
+     * notice the loss themselves and would decode the following frames against a stale
+     * reference, frames are only decoded again from the next keyframe on
+     */
+    virtual void reset() = 0;
+
+};
+
+/***
+ * encodes every frame as JPEG with the parameters of a QualityController
+ */
+class JpegEncoder : public VideoEncoder {
+public:
+
+    explicit JpegEncoder(QualityController &quality);
+
+    codec_t codec() const override;
+
+    void encode(const cv::Mat &frame, std::vector<unsigned char> &buffer) override;
+
+    void requestKeyframe() override;
+
+    bool keyframe() const override;
+
+    cv::Size size() const override;
+
+private:
+
+    QualityController &_quality;
+
+};
+
+class JpegDecoder : public VideoDecoder {
+public:
+
+    bool decode(const std::vector<unsigned char> &data, cv::Mat &frame) override;
+
+    void reset() override;
+
+};
+
+#endif // __VIDEOCODEC_HPP
@@ -1,7 +1,18 @@
 #include <VideoReceiver.hpp>
 
-VideoReceiver::VideoReceiver(const std::string &host, int port) {
-    _socket = Socket::connect(host, port);
+VideoReceiver::VideoReceiver(const std::string &host, int port, Socket::transport_t transport,
+                             VideoEncoder::codec_t codec) :
+        _hostname(host), _codec(codec) {
+    if (transport == Socket::UDP) {
+        _decoder = VideoDecoder::create(codec);
+        _udp.reset(new UdpReceiver);
+        _udp->connect(host, (unsigned short) port);
+    } else if (transport == Socket::SHM) {
+        _shm.reset(new ShmReceiver);
+        _shm->connect(shared_ring::name(port));
+    } else {
+        _socket = Socket::connect(host, port);
+    }
 }
 
 VideoReceiver::~VideoReceiver() {
@@ -14,20 +25,66 @@ VideoReceiver &VideoReceiver::operator>>(cv::Mat &frame) {
 }
 
 bool VideoReceiver::read(cv::Mat &frame) {
-    uint32_t n = 0;
-    if (_socket.read(&n, sizeof(n)) != sizeof(n)) {
+    if (!isConnected()) {
         return false;
     }
-    n = ntohl(n);
-    _buffer.resize(n);
-    try {
-        if (_socket.read(_buffer.data(), n) != n) {
+    if (_shm) {
+        // zero copy, the frame refers to the slot the receiver holds until the next read
+        shared_ring::Frame raw;
+        if (!_shm->read(raw)) {
             return false;
         }
-        cv::imdecode(_buffer, cv::IMREAD_COLOR, &frame);
+        frame = cv::Mat(raw.rows, raw.cols, raw.type, raw.data, raw.step);
+        _frame_size = raw.rows * raw.step;
+        _frame_tag = raw.tag;
         return true;
+    }
+    if (_udp) {
+        // incomplete frames are skipped, false only if nothing arrives for a while
+        uint64_t incomplete = _udp->stats().incomplete;
+        while (_udp->read(_buffer)) {
+            const bool lost = _udp->stats().incomplete != incomplete;
+            incomplete = _udp->stats().incomplete;
+            // the frame carries no frame number, the decoder has to be told that its reference is gone
+            if (lost) {
+                _decoder->reset();
+            }
+            if (_decoder->decode(_buffer, frame)) {
+                _waiting = false;
+                _frame_size = _buffer.size();
+                _frame_tag = _udp->tag();
+                return true;
+            }
+            // an inter-frame codec cannot continue after a lost frame, the keyframe
+            // is only requested again if frames get lost while waiting for it
+            if (_codec != VideoEncoder::JPEG && (lost || !_waiting)) {
+                _udp->requestKeyframe();
+                _waiting = true;
+            }
+        }
+        return false;
+    }
+    try {
+        // messages other than frames are skipped, as are frames that cannot be decoded
+        protocol::Header header;
+        while (true) {
+            _socket.recv(header, _buffer);
+            if (header.type != protocol::JPEG_FRAME && header.type != protocol::VP8_FRAME) {
+                continue;
+            }
+            const VideoEncoder::codec_t codec =
+                    header.type == protocol::VP8_FRAME ? VideoEncoder::VP8 : VideoEncoder::JPEG;
+            if (!_decoder || codec != _codec) {
+                _decoder = VideoDecoder::create(codec);
+                _codec = codec;
+            }
+            if (_decoder->decode(_buffer, frame)) {
+                _frame_size = _buffer.size();
+                return true;
+            }
+        }
     } catch (std::exception &ex) {
-        // peer has been disconnected
+        // peer has been disconnected or the codec is not available
         close();
     }
     return false;
@@ -35,8 +92,28 @@ bool VideoReceiver::read(cv::Mat &frame) {
 
 void VideoReceiver::close() {
     _socket.close();
+    _udp.reset();
+    _shm.reset();
 }
 
 bool VideoReceiver::isConnected() const {
-    return _socket.is_open();
+    return _socket.isOpen() || (_udp && _udp->isOpen()) || (_shm && _shm->isOpen());
+}
+
+void VideoReceiver::setDeadline(double ms) {
+    if (_udp) {
+        _udp->setDeadline(ms);
+    }
+}
+
+size_t VideoReceiver::frameSize() const {
+    return _frame_size;
+}
+
+uint64_t VideoReceiver::frameTag() const {
+    return _frame_tag;
+}
+
+UdpReceiver::Stats VideoReceiver::getStats() const {
+    return _udp ? _udp->stats() : UdpReceiver::Stats();
 }
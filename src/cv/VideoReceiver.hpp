@@ -2,7 +2,12 @@
 #define __VIDEORECEIVER_HPP
 
 #include <string>
+#include <memory>
 #include <Socket.hpp>
+#include <Protocol.hpp>
+#include <UdpReceiver.hpp>
+#include <ShmReceiver.hpp>
+#include <VideoCodec.hpp>
 #include <opencv2/opencv.hpp>
 #include <vector>
 
@@ -11,26 +16,80 @@ public:
 
     VideoReceiver() = default;
 
-    VideoReceiver(const std::string &host, int port);
+    /***
+     * connect to a streamer
+     * @param host
+     * @param port
+     * @param transport SHM attaches to the streamer of the port on the local machine, host is ignored then
+     * @param codec codec of the frames sent over UDP, over TCP every frame carries its codec
+     */
+    VideoReceiver(const std::string &host, int port, Socket::transport_t transport=Socket::TCP,
+                  VideoEncoder::codec_t codec=VideoEncoder::JPEG);
 
     ~VideoReceiver();
 
     VideoReceiver& operator>>(cv::Mat &frame);
 
+    /***
+     * read the next frame
+     * @param frame over shared memory it refers to the segment and is valid until the next read,
+     *          it has to be cloned to be kept any longer
+     * @return
+     */
     bool read(cv::Mat &frame);
 
     void close();
 
     bool isConnected() const;
 
+    /***
+     * set the time a frame may take to arrive completely over UDP, incomplete frames are dropped
+     * @param ms
+     */
+    void setDeadline(double ms);
+
+    /***
+     * get the size of the last frame as it has been received, compressed over TCP and UDP
+     * @return in bytes
+     */
+    size_t frameSize() const;
+
+    /***
+     * get the tag the streamer has given the last frame over UDP and SHM, the host tags
+     * a frame with its number, over UDP it is cut to 32 bit
+     * @return 0 over TCP
+     */
+    uint64_t frameTag() const;
+
+    /***
+     * get loss and jitter of the UDP transport
+     * @return
+     */
+    UdpReceiver::Stats getStats() const;
+
 private:
 
     std::string _hostname;
 
     Socket _socket;
 
+    std::unique_ptr<UdpReceiver> _udp;
+
+    std::unique_ptr<ShmReceiver> _shm;
+
+    VideoEncoder::codec_t _codec = VideoEncoder::JPEG;
+
+    std::unique_ptr<VideoDecoder> _decoder;
+
+    // a keyframe has been requested and not arrived yet
+    bool _waiting = false;
+
     std::vector<unsigned char> _buffer;
 
+    size_t _frame_size = 0;
+
+    uint64_t _frame_tag = 0;
+
 };
 
 #endif // __VIDEORECEIVER_HPP
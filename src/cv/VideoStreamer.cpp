@@ -1,12 +1,30 @@
 #include <VideoStreamer.hpp>
-#include <ros/
+#include <chrono>
+#include <stdexcept>
 
-VideoStreamer::VideoStreamer(int port) {
-    _server = ServerSocket(port);
-}
+VideoStreamer::VideoStreamer(int port, Socket::transport_t transport, framing::policy_t policy) :
+        _port(port), _transport(transport), _policy(policy), _encoder(new JpegEncoder(_quality)) {}
 
 void VideoStreamer::waitForConnection() {
-    _socket = _server.wait_for_connection();
+    if (_transport == Socket::UDP) {
+        // the receiver registers itself with a datagram
+        _udp.reset(new UdpSender);
+        _udp->setLoss(_loss);
+        _udp->open((unsigned short) _port);
+        _udp->waitForReceiver();
+    } else if (_transport == Socket::SHM) {
+        // the port names the segment, the receiver attaches to it
+        _shm.reset(new ShmSender);
+        _shm->open(shared_ring::name(_port), _shm_capacity);
+        _shm->waitForReceiver();
+    } else {
+        _socket = Socket::accept(Socket::IPv4, _port);
+        _socket.setPolicy(_policy);
+    }
+    // a new client needs a keyframe to start decoding from
+    if (_encoder) {
+        _encoder->requestKeyframe();
+    }
 }
 
 VideoStreamer::~VideoStreamer() {
@@ -20,21 +38,97 @@ VideoStreamer &VideoStreamer::operator<<(const cv::Mat &frame) {
 
 bool VideoStreamer::write(const cv::Mat &frame) {
     CV_Assert(!frame.empty());
-    if (!_socket.is_open()) {
+    if (!isConnected()) {
         return false;
     }
-    uint32_t n = 0;
-    cv::imencode(".jpeg", frame, _buffer);
-    n = htonl((uint32_t) _buffer.size());
-    return !(_socket.write(&n, sizeof(n)) != sizeof(n) ||
-             _socket.write(_buffer.data(), _buffer.size()) != _buffer.size());
+    if (_shm) {
+        return writeShm(frame);
+    }
+    if (!_encoder) {
+        _encoder.reset(new JpegEncoder(_quality));
+    }
+    if (_udp && _udp->joined()) {
+        _encoder->requestKeyframe();
+    }
+    _encoder->encode(frame, _buffer);
+    if (_buffer.empty()) {
+        // the encoder has skipped the frame
+        return true;
+    }
+    const auto begin = std::chrono::steady_clock::now();
+    size_t bytes = _buffer.size();
+    try {
+        if (_udp) {
+            if (!_udp->send(_buffer)) {
+                close();
+                return false;
+            }
+        } else {
+            _writer.add(_encoder->codec() == VideoEncoder::VP8 ? protocol::VP8_FRAME : protocol::JPEG_FRAME, _buffer);
+            bytes = _writer.size();
+            _socket.send(_writer);
+        }
+    } catch (std::exception &ex) {
+        // peer has been disconnected
+        close();
+        return false;
+    }
+    if (_adaptive) {
+        _quality.update(bytes, std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - begin).count(), -1);
+    }
+    return true;
+}
+
+bool VideoStreamer::writeShm(const cv::Mat &frame) {
+    // raw frames are written straight into the slot of the segment
+    const size_t step = frame.cols * frame.elemSize();
+    try {
+        unsigned char *slot = _shm->acquire(frame.rows * step);
+        cv::Mat image(frame.rows, frame.cols, frame.type(), slot, step);
+        frame.copyTo(image);
+        if (_shm->publish(frame.rows, frame.cols, frame.type(), step)) {
+            return true;
+        }
+    } catch (std::exception &ex) {
+        // frame does not fit into the segment
+    }
+    close();
+    return false;
+}
+
+void VideoStreamer::setCodec(VideoEncoder::codec_t codec, unsigned int bitrate) {
+    _encoder = VideoEncoder::create(codec, _quality, bitrate);
+}
+
+void VideoStreamer::setTargetLatency(double ms) {
+    _adaptive = ms > 0.0;
+    if (_adaptive) {
+        _quality.setTargetLatency(ms);
+    }
+}
+
+QualityController& VideoStreamer::getQualityController() {
+    return _quality;
+}
+
+void VideoStreamer::setLoss(double probability) {
+    _loss = probability;
+    if (_udp) {
+        _udp->setLoss(probability);
+    }
+}
+
+void VideoStreamer::setShmCapacity(size_t bytes) {
+    _shm_capacity = bytes;
 }
 
 void VideoStreamer::close() {
     _socket.close();
-    _server.close();
+    _udp.reset();
+    _shm.reset();
 }
 
 bool VideoStreamer::isConnected() const {
-    return _socket.is_open();
+    return _socket.isOpen() || (_udp && _udp->isOpen()) || (_shm && _shm->isOpen());
 }
@@ -2,16 +2,23 @@
 #define __VIDEOSTREAMER_HPP
 
 #include <vector>
+#include <memory>
 #include <opencv2/opencv.hpp>
-#include <ServerSocket.hpp>
 #include <Socket.hpp>
+#include <Framing.hpp>
+#include <Protocol.hpp>
+#include <UdpSender.hpp>
+#include <ShmSender.hpp>
+#include <QualityController.hpp>
+#include <VideoCodec.hpp>
 
 class VideoStreamer {
 public:
 
     VideoStreamer() = default;
 
-    VideoStreamer(int port);
+    explicit VideoStreamer(int port, Socket::transport_t transport=Socket::TCP,
+                           framing::policy_t policy=framing::NODELAY);
 
     ~VideoStreamer();
 
@@ -21,18 +28,72 @@ public:
 
     bool write(const cv::Mat &frame);
 
+    /***
+     * select the codec the frames are compressed with, JPEG by default
+     * @param codec
+     * @param bitrate target bitrate in kbit/s of inter-frame codecs
+     */
+    void setCodec(VideoEncoder::codec_t codec, unsigned int bitrate=1000);
+
+    /***
+     * adapt JPEG quality and resolution to the link so that sending a frame
+     * takes at most this long
+     * @param ms 0 streams at the maximum quality and full resolution
+     */
+    void setTargetLatency(double ms);
+
+    /***
+     * get handle to the controller to adjust its parameters or read the current ones
+     * @return
+     */
+    QualityController& getQualityController();
+
+    /***
+     * drop datagrams on purpose to test the UDP transport over a lossless link
+     * @param probability in [0, 1]
+     */
+    void setLoss(double probability);
+
+    /***
+     * set the largest frame that can be passed through shared memory
+     * @param bytes
+     */
+    void setShmCapacity(size_t bytes);
+
     void close();
 
     bool isConnected() const;
 
 private:
 
-    ServerSocket _server;
+    bool writeShm(const cv::Mat &frame);
+
+    int _port = 0;
+
+    Socket::transport_t _transport = Socket::TCP;
+
+    framing::policy_t _policy = framing::NODELAY;
 
     Socket _socket;
 
+    std::unique_ptr<UdpSender> _udp;
+
+    std::unique_ptr<ShmSender> _shm;
+
+    size_t _shm_capacity = shared_ring::DEFAULT_CAPACITY;
+
+    double _loss = 0.0;
+
     std::vector<unsigned char> _buffer;
 
+    protocol::Writer _writer;
+
+    QualityController _quality;
+
+    std::unique_ptr<VideoEncoder> _encoder;
+
+    bool _adaptive = false;
+
 };
 
 #endif // __VIDEOSTREAMER_HPP
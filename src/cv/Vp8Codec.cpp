@@ -0,0 +1,182 @@
+#include <Vp8Codec.hpp>
+#include <vpx/vp8cx.h>
+#include <vpx/vp8dx.h>
+#include <opencv2/imgproc.hpp>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+// time base of the presentation timestamps, frames are simply counted
+static const int FRAME_RATE = 30;
+
+Vp8Encoder::Vp8Encoder(unsigned int bitrate, unsigned int threads) :
+        _bitrate(bitrate), _threads(std::max(threads, 1u)) {}
+
+Vp8Encoder::~Vp8Encoder() {
+    release();
+}
+
+VideoEncoder::codec_t Vp8Encoder::codec() const {
+    return VP8;
+}
+
+void Vp8Encoder::init(int width, int height) {
+    release();
+
+    vpx_codec_enc_cfg_t cfg;
+    if (vpx_codec_enc_config_default(vpx_codec_vp8_cx(), &cfg, 0) != VPX_CODEC_OK) {
+        throw std::runtime_error("unable to get VP8 encoder configuration");
+    }
+    cfg.g_w = (unsigned int) width;
+    cfg.g_h = (unsigned int) height;
+    cfg.g_timebase.num = 1;
+    cfg.g_timebase.den = FRAME_RATE;
+    cfg.g_threads = _threads;
+    // no lookahead, every frame is output right away
+    cfg.g_lag_in_frames = 0;
+    cfg.g_pass = VPX_RC_ONE_PASS;
+    cfg.g_error_resilient = VPX_ERROR_RESILIENT_DEFAULT;
+    cfg.rc_end_usage = VPX_CBR;
+    cfg.rc_target_bitrate = _bitrate;
+    cfg.rc_min_quantizer = 4;
+    cfg.rc_max_quantizer = 56;
+    cfg.rc_undershoot_pct = 95;
+    // small buffers, the bitrate is held over a short window
+    cfg.rc_buf_sz = 300;
+    cfg.rc_buf_initial_sz = 200;
+    cfg.rc_buf_optimal_sz = 250;
+    cfg.rc_dropframe_thresh = 0;
+    cfg.kf_mode = VPX_KF_AUTO;
+    cfg.kf_max_dist = 10 * FRAME_RATE;
+
+    if (vpx_codec_enc_init(&_codec, vpx_codec_vp8_cx(), &cfg, 0) != VPX_CODEC_OK) {
+        throw std::runtime_error("unable to initialize VP8 encoder");
+    }
+    _initialized = true;
+    vpx_codec_control(&_codec, VP8E_SET_CPUUSED, 8);
+    vpx_codec_control(&_codec, VP8E_SET_NOISE_SENSITIVITY, 0);
+    vpx_codec_control(&_codec, VP8E_SET_STATIC_THRESHOLD, 1);
+    vpx_codec_control(&_codec, VP8E_SET_ENABLEAUTOALTREF, 0);
+    vpx_codec_control(&_codec, VP8E_SET_TOKEN_PARTITIONS, 0);
+
+    _size = cv::Size(width, height);
+    _pts = 0;
+    _force_keyframe = true;
+}
+
+void Vp8Encoder::release() {
+    if (_initialized) {
+        vpx_codec_destroy(&_codec);
+        _initialized = false;
+    }
+}
+
+void Vp8Encoder::encode(const cv::Mat &frame, std::vector<unsigned char> &buffer) {
+    CV_Assert(!frame.empty() && frame.type() == CV_8UC3);
+    _frame_size = cv::Size(frame.cols, frame.rows);
+    // chroma is subsampled, the dimensions must be even
+    const cv::Mat image = frame(cv::Rect(0, 0, frame.cols & ~1, frame.rows & ~1));
+    if (!_initialized || cv::Size(image.cols, image.rows) != _size) {
+        init(image.cols, image.rows);
+    }
+
+    cv::cvtColor(image, _yuv, cv::COLOR_BGR2YUV_I420);
+    vpx_image_t img;
+    vpx_img_wrap(&img, VPX_IMG_FMT_I420, (unsigned int) image.cols, (unsigned int) image.rows, 1, _yuv.data);
+
+    const vpx_enc_frame_flags_t flags = _force_keyframe ? VPX_EFLAG_FORCE_KF : 0;
+    if (vpx_codec_encode(&_codec, &img, _pts++, 1, flags, VPX_DL_REALTIME) != VPX_CODEC_OK) {
+        throw std::runtime_error(std::string("VP8 encoding failed: ") + vpx_codec_error(&_codec));
+    }
+    _force_keyframe = false;
+
+    // without lookahead all packets of the frame are available right away
+    buffer.clear();
+    _keyframe = false;
+    vpx_codec_iter_t iter = nullptr;
+    const vpx_codec_cx_pkt_t *pkt;
+    while ((pkt = vpx_codec_get_cx_data(&_codec, &iter)) != nullptr) {
+        if (pkt->kind == VPX_CODEC_CX_FRAME_PKT) {
+            const auto data = static_cast<const unsigned char*>(pkt->data.frame.buf);
+            buffer.insert(buffer.end(), data, data + pkt->data.frame.sz);
+            _keyframe |= (pkt->data.frame.flags & VPX_FRAME_IS_KEY) != 0;
+        }
+    }
+}
+
+void Vp8Encoder::requestKeyframe() {
+    _force_keyframe = true;
+}
+
+bool Vp8Encoder::keyframe() const {
+    return _keyframe;
+}
+
+cv::Size Vp8Encoder::size() const {
+    // odd rows and columns are cut off, not scaled
+    return _frame_size;
+}
+
+Vp8Decoder::Vp8Decoder() {
+    vpx_codec_dec_cfg_t cfg;
+    std::memset(&cfg, 0, sizeof(cfg));
+    cfg.threads = 1;
+    if (vpx_codec_dec_init(&_codec, vpx_codec_vp8_dx(), &cfg, 0) != VPX_CODEC_OK) {
+        throw std::runtime_error("unable to initialize VP8 decoder");
+    }
+}
+
+Vp8Decoder::~Vp8Decoder() {
+    vpx_codec_destroy(&_codec);
+}
+
+bool Vp8Decoder::decode(const std::vector<unsigned char> &data, cv::Mat &frame) {
+    if (data.empty()) {
+        return false;
+    }
+    // the lowest bit of the frame tag is cleared for keyframes
+    const bool keyframe = (data[0] & 0x01) == 0;
+    if (!_synced && !keyframe) {
+        return false;
+    }
+
+    if (vpx_codec_decode(&_codec, data.data(), (unsigned int) data.size(), nullptr, 0) != VPX_CODEC_OK) {
+        _synced = false;
+        return false;
+    }
+    int corrupted = 0;
+    vpx_codec_control(&_codec, VP8D_GET_FRAME_CORRUPTED, &corrupted);
+    if (corrupted) {
+        _synced = false;
+        return false;
+    }
+    _synced = true;
+
+    vpx_codec_iter_t iter = nullptr;
+    const vpx_image_t *img = vpx_codec_get_frame(&_codec, &iter);
+    if (img == nullptr) {
+        return false;
+    }
+
+    // copy the planes into one contiguous I420 image
+    const int width = (int) img->d_w;
+    const int height = (int) img->d_h;
+    _yuv.create(height * 3 / 2, width, CV_8UC1);
+    unsigned char *dst = _yuv.data;
+    for (int plane = 0; plane < 3; ++plane) {
+        const int w = plane == 0 ? width : width / 2;
+        const int h = plane == 0 ? height : height / 2;
+        const unsigned char *src = img->planes[plane];
+        for (int y = 0; y < h; ++y, dst += w) {
+            std::memcpy(dst, src + y * img->stride[plane], (size_t) w);
+        }
+    }
+    cv::cvtColor(_yuv, frame, cv::COLOR_YUV2BGR_I420);
+    return true;
+}
+
+void Vp8Decoder::reset() {
+    // a keyframe replaces all reference frames, the context can be kept
+    _synced = false;
+}
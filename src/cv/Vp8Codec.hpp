@@ -0,0 +1,105 @@
+#ifndef __VP8CODEC_HPP
+#define __VP8CODEC_HPP
+
+#include <vector>
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <vpx/vpx_encoder.h>
+#include <vpx/vpx_decoder.h>
+#include <VideoCodec.hpp>
+
+/***
+ * VP8 encoder of libvpx tuned for latency instead of compression:
+ * no frames are held back for lookahead or alternate reference frames,
+ * so every frame leaves the encoder the moment it has been passed in,
+ * encoding runs at realtime speed with a constant bitrate and blocks of
+ * a static scene are skipped.
+ * The encoder is set up with the size of the first frame and again
+ * whenever the size changes.
+ */
+class Vp8Encoder : public VideoEncoder {
+public:
+
+    /***
+     * create encoder
+     * @param bitrate target bitrate in kbit/s
+     * @param threads number of encoder threads
+     */
+    explicit Vp8Encoder(unsigned int bitrate=1000, unsigned int threads=1);
+
+    Vp8Encoder(const Vp8Encoder &encoder) = delete;
+
+    ~Vp8Encoder() override;
+
+    Vp8Encoder& operator=(const Vp8Encoder &encoder) = delete;
+
+    codec_t codec() const override;
+
+    void encode(const cv::Mat &frame, std::vector<unsigned char> &buffer) override;
+
+    void requestKeyframe() override;
+
+    bool keyframe() const override;
+
+    cv::Size size() const override;
+
+private:
+
+    void init(int width, int height);
+
+    void release();
+
+    unsigned int _bitrate;
+
+    unsigned int _threads;
+
+    vpx_codec_ctx_t _codec;
+
+    bool _initialized = false;
+
+    cv::Size _size;
+
+    // size of the last frame passed in, it is encoded without scaling
+    cv::Size _frame_size;
+
+    vpx_codec_pts_t _pts = 0;
+
+    bool _force_keyframe = true;
+
+    bool _keyframe = false;
+
+    cv::Mat _yuv;
+
+};
+
+/***
+ * VP8 decoder of libvpx, frames are only decoded after a keyframe
+ * has been received and until a frame turns out to be corrupt
+ */
+class Vp8Decoder : public VideoDecoder {
+public:
+
+    Vp8Decoder();
+
+    Vp8Decoder(const Vp8Decoder &decoder) = delete;
+
+    ~Vp8Decoder() override;
+
+    Vp8Decoder& operator=(const Vp8Decoder &decoder) = delete;
+
+    bool decode(const std::vector<unsigned char> &data, cv::Mat &frame) override;
+
+    void reset() override;
+
+private:
+
+    vpx_codec_ctx_t _codec;
+
+    // a keyframe has been decoded and no frame has been lost since
+    bool _synced = false;
+
+    cv::Mat _yuv;
+
+};
+
+#endif // __VP8CODEC_HPP
@@ -0,0 +1,125 @@
+#include <ControlChannel.hpp>
+#include <iostream>
+
+ControlChannel::ControlChannel(boost::asio::ip::tcp::socket &socket, const std::map<char, action_t> &actions) :
+        _socket(socket), _actions(actions) {}
+
+ControlChannel::~ControlChannel() {
+    stop();
+}
+
+void ControlChannel::start(const action_t &on_close) {
+    stop();
+    _on_close = on_close;
+    _running = true;
+    read();
+}
+
+void ControlChannel::stop() {
+    if (_running.exchange(false)) {
+        boost::system::error_code error;
+        _socket.cancel(error);
+    }
+}
+
+void ControlChannel::setOnPing(const ping_t &on_ping) {
+    _on_ping = on_ping;
+}
+
+bool ControlChannel::isRunning() const {
+    return _running;
+}
+
+uint64_t ControlChannel::commands() const {
+    return _commands;
+}
+
+double ControlChannel::meanLatency() const {
+    const uint64_t n = _commands;
+    return n > 0 ? double(_total_latency) / double(n) : 0.0;
+}
+
+uint64_t ControlChannel::maxLatency() const {
+    return _max_latency;
+}
+
+void ControlChannel::read() {
+    boost::asio::async_read(_socket, boost::asio::buffer(&_header, protocol::HEADER_SIZE),
+                            [this](const boost::system::error_code &error, size_t) {
+        if (error) {
+            // aborted reads have been cancelled by stop()
+            if (error != boost::asio::error::operation_aborted) {
+                std::cout << error.message() << std::endl;
+                std::cout << "unable to read data from socket" << std::endl;
+                close();
+            }
+            return;
+        }
+
+        _received = std::chrono::steady_clock::now();
+        protocol::swap(_header);
+        if (!protocol::valid(_header)) {
+            // the stream cannot be resynchronized
+            std::cout << "invalid message of protocol version " << (int) _header.version << std::endl;
+            close();
+            return;
+        }
+        readPayload();
+    });
+}
+
+void ControlChannel::readPayload() {
+    _payload.resize(_header.length);
+    boost::asio::async_read(_socket, boost::asio::buffer(_payload),
+                            [this](const boost::system::error_code &error, size_t) {
+        if (error) {
+            if (error != boost::asio::error::operation_aborted) {
+                std::cout << error.message() << std::endl;
+                std::cout << "unable to read data from socket" << std::endl;
+                close();
+            }
+            return;
+        }
+        dispatch();
+    });
+}
+
+void ControlChannel::dispatch() {
+    if (_header.type == protocol::PING) {
+        if (_on_ping) {
+            _on_ping(_header.seq, _header.timestamp);
+        }
+    } else if (_header.type == protocol::COMMAND && !_payload.empty()) {
+        const char command = (char) _payload[0];
+        if (command == 'x') {
+            std::cout << "connection terminated by peer" << std::endl;
+            close();
+            return;
+        }
+
+        const auto it = _actions.find(command);
+        if (it != _actions.end()) {
+            const auto &func = it->second;
+            func();
+
+            const uint64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - _received).count();
+            _commands += 1;
+            _total_latency += latency;
+            uint64_t max = _max_latency;
+            while (latency > max && !_max_latency.compare_exchange_weak(max, latency));
+        } else {
+            std::cout << "unrecognized action \'" << command << '\'' << std::endl;
+        }
+    }
+
+    // wait for the next message, other types are skipped
+    read();
+}
+
+void ControlChannel::close() {
+    _running = false;
+    if (_on_close) {
+        _on_close();
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef __CONTROLCHANNEL_HPP
+#define __CONTROLCHANNEL_HPP
+
+#include <map>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <boost/asio.hpp>
+#include <Protocol.hpp>
+
+/***
+ * Reads control messages from the client with asynchronous reads and runs
+ * the action mapped to a command the moment it arrives, independent of the
+ * video pipeline. Messages of other channels or unknown types are skipped.
+ * The reads are completed by the thread that runs the io_service the
+ * socket belongs to.
+ * The time between a command being received and its action having been
+ * executed is recorded as the command-to-actuation latency.
+ */
+class ControlChannel {
+public:
+
+    typedef std::function<void (void)>  action_t;
+
+    // called with sequence number and timestamp of a ping
+    typedef std::function<void (uint32_t, uint64_t)>   ping_t;
+
+    /***
+     * create control channel on an already connected socket
+     * @param socket connected socket, only read from by the channel
+     * @param actions maps commands to actions
+     */
+    ControlChannel(boost::asio::ip::tcp::socket &socket, const std::map<char, action_t> &actions);
+
+    ControlChannel(const ControlChannel &channel) = delete;
+
+    ~ControlChannel();
+
+    ControlChannel& operator=(const ControlChannel &channel) = delete;
+
+    /***
+     * start reading commands
+     * @param on_close called from the io_service's thread when the peer has terminated
+     *                  the connection or reading failed
+     */
+    void start(const action_t &on_close=action_t());
+
+    /***
+     * set the function that answers pings, must be set before start()
+     * @param on_ping
+     */
+    void setOnPing(const ping_t &on_ping);
+
+    /***
+     * stop reading commands, has to be called from the io_service's thread
+     * or while the io_service is not running
+     */
+    void stop();
+
+    /***
+     * check whether the channel is still reading commands
+     * @return
+     */
+    bool isRunning() const;
+
+    /***
+     * get the number of commands that have been executed
+     * @return
+     */
+    uint64_t commands() const;
+
+    /***
+     * get the mean command-to-actuation latency in usec
+     * @return
+     */
+    double meanLatency() const;
+
+    /***
+     * get the maximum command-to-actuation latency in usec
+     * @return
+     */
+    uint64_t maxLatency() const;
+
+private:
+
+    void read();
+
+    void readPayload();
+
+    void dispatch();
+
+    void close();
+
+    boost::asio::ip::tcp::socket &_socket;
+
+    std::map<char, action_t> _actions;
+
+    action_t _on_close;
+
+    ping_t _on_ping;
+
+    std::atomic_bool _running { false };
+
+    protocol::Header _header;
+
+    std::vector<unsigned char> _payload;
+
+    std::chrono::steady_clock::time_point _received;
+
+    // latency statistics in usec
+    std::atomic<uint64_t> _commands { 0 };
+
+    std::atomic<uint64_t> _total_latency { 0 };
+
+    std::atomic<uint64_t> _max_latency { 0 };
+
+};
+
+#endif // __CONTROLCHANNEL_HPP
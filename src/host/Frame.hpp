@@ -0,0 +1,42 @@
+#ifndef __FRAME_HPP
+#define __FRAME_HPP
+
+#include <cstdint>
+#include <chrono>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <ObjectDetector.hpp>
+#include <VideoCodec.hpp>
+
+/***
+ * unit of work that is passed through the stages of the host pipeline,
+ * every stage fills in its part and hands the frame on to the next one
+ */
+struct Frame {
+
+    // sequence number assigned by the camera grabber
+    uint64_t id = 0;
+
+    // time the image has been taken from the camera
+    std::chrono::steady_clock::time_point timestamp;
+
+    // camera image, annotated in place if the host draws the predictions
+    cv::Mat image;
+
+    // detector output for this image
+    std::vector<Prediction> predictions;
+
+    // compressed image as it is sent to the client
+    std::vector<unsigned char> buffer;
+
+    // codec of the compressed image and if it can be decoded without the frames before it
+    VideoEncoder::codec_t codec = VideoEncoder::JPEG;
+
+    bool keyframe = true;
+
+    // predictions serialized as detection message with the frame's id, sent ahead of the image
+    std::vector<unsigned char> detections;
+
+};
+
+#endif // __FRAME_HPP
@@ -0,0 +1,111 @@
+#include <InferenceStage.hpp>
+#include <ScopedTimer.hpp>
+#include <stats.hpp>
+
+InferenceStage::InferenceStage(ModelSwitcher<ObjectDetector> &models) : _models(models) {}
+
+void InferenceStage::setDetectInterval(unsigned int interval) {
+    _interval = interval > 0 ? interval : 1;
+}
+
+void InferenceStage::setDetectBudget(double budget) {
+    CV_Assert(budget >= 0.0 && budget <= 1.0);
+    _budget = budget;
+}
+
+void InferenceStage::setMinTrackedFraction(double fraction) {
+    CV_Assert(fraction >= 0.0 && fraction <= 1.0);
+    _min_tracked = fraction;
+}
+
+void InferenceStage::setMotionGate(bool enable) {
+    _gate_enabled = enable;
+    _gate.reset();
+}
+
+BoxTracker& InferenceStage::getTracker() {
+    return _tracker;
+}
+
+MotionGate& InferenceStage::getMotionGate() {
+    return _gate;
+}
+
+void InferenceStage::process(Frame &frame) {
+    const auto detector = _models.get();
+    if (detector.get() != _detector) {
+        // the model has been switched, the old predictions are not valid anymore
+        _detector = detector.get();
+        _redetect = true;
+        _gate.reset();
+    }
+
+    if (_gate_enabled && !_gate.changed(frame.image)) {
+        // nothing has moved, the previous predictions are still valid
+        frame.predictions = _predictions;
+        _gated += 1;
+        return;
+    }
+
+    if (detectionDue()) {
+        const auto begin = std::chrono::steady_clock::now();
+        frame.predictions = detector->run(frame.image);
+        stats::record(stats::PREPROCESS, detector->getPreprocessTime());
+        stats::record(stats::FORWARD, detector->getForwardTime());
+        stats::record(stats::POSTPROCESS, detector->getPostprocessTime());
+
+        _last_detection = begin;
+        _last_duration = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - begin).count();
+        _frames_since_detection = 0;
+        _redetect = false;
+        _detections += 1;
+
+        if (trackingEnabled()) {
+            ScopedTimer timer(stats::histogram(stats::TRACK));
+            _tracker.init(frame.image, frame.predictions);
+        }
+    } else {
+        ScopedTimer timer(stats::histogram(stats::TRACK));
+        if (_tracker.update(frame.image, frame.predictions) < _min_tracked) {
+            _redetect = true;
+        }
+        _frames_since_detection += 1;
+        _tracked += 1;
+    }
+    _predictions = frame.predictions;
+}
+
+void InferenceStage::reset() {
+    _redetect = true;
+    _gate.reset();
+    _predictions.clear();
+}
+
+uint64_t InferenceStage::detections() const {
+    return _detections;
+}
+
+uint64_t InferenceStage::tracked() const {
+    return _tracked;
+}
+
+uint64_t InferenceStage::gated() const {
+    return _gated;
+}
+
+bool InferenceStage::trackingEnabled() const {
+    return _interval > 1 || _budget > 0.0;
+}
+
+bool InferenceStage::detectionDue() const {
+    if (_redetect || !trackingEnabled()) {
+        return true;
+    }
+    if (_budget > 0.0) {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - _last_detection).count();
+        return (double) elapsed >= (double) _last_duration / _budget;
+    }
+    return _frames_since_detection + 1 >= _interval;
+}
@@ -0,0 +1,138 @@
+#ifndef __INFERENCESTAGE_HPP
+#define __INFERENCESTAGE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ObjectDetector.hpp>
+#include <BoxTracker.hpp>
+#include <MotionGate.hpp>
+#include <Frame.hpp>
+#include <ModelSwitcher.hpp>
+
+/***
+ * Fills in the predictions of the frames passing through the host pipeline.
+ * The detector is only run every n-th frame or, if a budget is set, only as
+ * often as the budget allows, in between the boxes of the last detection are
+ * propagated by a BoxTracker. A detection is forced as soon as the tracker
+ * has lost too many boxes.
+ * Optionally a MotionGate in front of both skips all work on static scenes
+ * and reuses the previous predictions.
+ * The detector is taken from a ModelSwitcher for every frame, after the
+ * model has been switched the next frame is always detected.
+ */
+class InferenceStage {
+public:
+
+    explicit InferenceStage(ModelSwitcher<ObjectDetector> &models);
+
+    /***
+     * run the detector on every n-th frame, 1 disables tracking
+     * @param interval
+     */
+    void setDetectInterval(unsigned int interval);
+
+    /***
+     * limit the share of wall time spent in the detector instead of using a fixed interval
+     * a detection that took t is followed by the next one after t / budget at the earliest
+     * @param budget in (0, 1], 0 uses the detect interval
+     */
+    void setDetectBudget(double budget);
+
+    /***
+     * force a detection if less than this fraction of the detected boxes is still tracked
+     * @param fraction in [0, 1]
+     */
+    void setMinTrackedFraction(double fraction);
+
+    /***
+     * enable or disable skipping frames whose scene has not changed
+     * @param enable
+     */
+    void setMotionGate(bool enable);
+
+    /***
+     * get handle to the tracker to adjust its parameters
+     * @return
+     */
+    BoxTracker& getTracker();
+
+    /***
+     * get handle to the motion gate to adjust its parameters
+     * @return
+     */
+    MotionGate& getMotionGate();
+
+    /***
+     * set the predictions of the frame, either by detection or by tracking
+     * @param frame
+     */
+    void process(Frame &frame);
+
+    /***
+     * forget the previous predictions, the next frame is detected again
+     * e.g. after the pipeline has been idle
+     */
+    void reset();
+
+    /***
+     * get the number of frames the detector has been run on
+     * @return
+     */
+    uint64_t detections() const;
+
+    /***
+     * get the number of frames whose predictions have been tracked
+     * @return
+     */
+    uint64_t tracked() const;
+
+    /***
+     * get the number of frames that have been skipped by the motion gate
+     * @return
+     */
+    uint64_t gated() const;
+
+private:
+
+    bool trackingEnabled() const;
+
+    bool detectionDue() const;
+
+    ModelSwitcher<ObjectDetector> &_models;
+
+    // detector of the last detection, only compared against
+    const ObjectDetector *_detector = nullptr;
+
+    BoxTracker _tracker;
+
+    MotionGate _gate;
+
+    bool _gate_enabled = false;
+
+    // predictions of the last processed frame
+    std::vector<Prediction> _predictions;
+
+    unsigned int _interval = 1;
+
+    double _budget = 0.0;
+
+    double _min_tracked = 0.5;
+
+    // state of the last detection
+    std::chrono::steady_clock::time_point _last_detection;
+
+    uint64_t _last_duration = 0;
+
+    unsigned int _frames_since_detection = 0;
+
+    bool _redetect = true;
+
+    uint64_t _detections = 0;
+
+    uint64_t _tracked = 0;
+
+    uint64_t _gated = 0;
+
+};
+
+#endif // __INFERENCESTAGE_HPP
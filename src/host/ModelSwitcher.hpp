@@ -0,0 +1,159 @@
+#ifndef __MODELSWITCHER_HPP
+#define __MODELSWITCHER_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <functional>
+
+/***
+ * Holds the detection model that is currently in use and replaces it at
+ * runtime with one of a list of networks.
+ * The new model is created and warmed up on a background thread while the
+ * current one keeps serving frames, then it is swapped in atomically.
+ * Users get the model with get() for every frame, so a swap takes effect
+ * with the next frame. The replaced model is released on the background
+ * thread once no user holds it any more, so tearing it down never stalls
+ * the pipeline.
+ * @tparam T ObjectDetector or DetectorPool
+ */
+template <typename T>
+class ModelSwitcher {
+public:
+
+    // creates a ready to use model for the network with the given name
+    typedef std::function<std::shared_ptr<T> (const std::string &)> factory_t;
+
+    /***
+     * create switcher, no model is loaded yet
+     * @param nets names of the networks that can be switched between
+     * @param factory
+     */
+    ModelSwitcher(const std::vector<std::string> &nets, const factory_t &factory) :
+            _nets(nets), _factory(factory) {
+        if (nets.empty()) {
+            throw std::invalid_argument("no networks to switch between");
+        }
+    }
+
+    ModelSwitcher(const ModelSwitcher &switcher) = delete;
+
+    ~ModelSwitcher() {
+        release();
+    }
+
+    ModelSwitcher& operator=(const ModelSwitcher &switcher) = delete;
+
+    /***
+     * load the network with the given index on the calling thread
+     * @param index
+     */
+    void load(size_t index) {
+        load(index, _factory(_nets.at(index)));
+    }
+
+    /***
+     * use a model the caller has created for the network with the given index
+     * @param index
+     * @param model
+     */
+    void load(size_t index, const std::shared_ptr<T> &model) {
+        if (index >= _nets.size()) {
+            throw std::out_of_range("no network with index " + std::to_string(index));
+        }
+        std::atomic_store(&_model, model);
+        _index = index;
+    }
+
+    /***
+     * start loading the next network of the list in the background,
+     * the current model is used until the new one is ready
+     * @return false if a network is already being loaded
+     */
+    bool next() {
+        if (_loading.exchange(true)) {
+            return false;
+        }
+        // the last load has finished
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+
+        const size_t index = (_index + 1) % _nets.size();
+        _thread = std::thread([this, index] {
+            const auto begin = std::chrono::steady_clock::now();
+            try {
+                std::shared_ptr<T> model = _factory(_nets[index]);
+                model = std::atomic_exchange(&_model, model);
+                _index = index;
+                std::cout << "switched to " << _nets[index] << " in " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - begin).count() << "ms" << std::endl;
+
+                // wait for the stages still working with the old model
+                while (model.use_count() > 1) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            } catch (std::exception &ex) {
+                std::cout << "unable to load " << _nets[index] << ": " << ex.what() << std::endl;
+            }
+            _loading = false;
+        });
+        return true;
+    }
+
+    /***
+     * get the model that is currently in use
+     * @return
+     */
+    std::shared_ptr<T> get() const {
+        return std::atomic_load(&_model);
+    }
+
+    /***
+     * get the name of the network that is currently in use
+     * @return
+     */
+    const std::string& current() const {
+        return _nets[_index];
+    }
+
+    /***
+     * check whether a network is being loaded in the background
+     * @return
+     */
+    bool isLoading() const {
+        return _loading;
+    }
+
+    /***
+     * wait for a background load to finish and release the model
+     */
+    void release() {
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+        std::atomic_store(&_model, std::shared_ptr<T>());
+    }
+
+private:
+
+    std::vector<std::string> _nets;
+
+    factory_t _factory;
+
+    std::shared_ptr<T> _model;
+
+    std::atomic<size_t> _index { 0 };
+
+    std::atomic_bool _loading { false };
+
+    std::thread _thread;
+
+};
+
+#endif // __MODELSWITCHER_HPP
@@ -0,0 +1,350 @@
+#include <StreamServer.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include <csignal>
+
+using boost::asio::ip::tcp;
+
+StreamServer::StreamServer(unsigned short port, const std::map<char, action_t> &actions) :
+        _acceptor(_service, tcp::endpoint(tcp::v4(), port)), _socket(_service), _signals(_service, SIGINT, SIGTERM),
+        _actions(actions), _port(port) {}
+
+StreamServer::~StreamServer() {
+    stop();
+}
+
+void StreamServer::setMaxClients(size_t n) {
+    _max_clients = std::max<size_t>(n, 1);
+}
+
+void StreamServer::setPolicy(framing::policy_t policy) {
+    _policy = policy;
+}
+
+void StreamServer::setTransport(Socket::transport_t transport, size_t capacity) {
+    _udp.reset();
+    _shm.reset();
+    switch (transport) {
+        case Socket::TCP:
+            break;
+        case Socket::UDP:
+            // the client registers itself with a hello to the port, frames go to the last one
+            _udp.reset(new UdpSender);
+            _udp->open(_port);
+            break;
+        case Socket::SHM:
+            // the segment is named after the port, a client attaches to it and detaches when it leaves
+            _shm.reset(new ShmSender);
+            _shm->open(shared_ring::name(_port), capacity);
+            break;
+        default:
+            throw std::invalid_argument("transport not supported by the stream server");
+    }
+    _transport = transport;
+}
+
+void StreamServer::setFeedback(const feedback_t &feedback) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _feedback = feedback;
+    if (_controller) {
+        _controller->setFeedback(feedback);
+    }
+}
+
+void StreamServer::setKeyframeRequest(const action_t &action) {
+    _request_keyframe = action;
+}
+
+void StreamServer::setOnControlLost(const action_t &action) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _on_control_lost = action;
+}
+
+void StreamServer::start() {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _stopped = false;
+    }
+    _work.reset(new boost::asio::io_service::work(_service));
+    accept();
+
+    // terminate gracefully, the owner notices through waitForClient() or isStopped()
+    _signals.async_wait([this](const boost::system::error_code &error, int) {
+        if (error) {
+            return;
+        }
+        std::cout << "terminating" << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _stopped = true;
+        }
+        _connected.notify_all();
+    });
+    _thread = std::thread([this]{ _service.run(); });
+}
+
+void StreamServer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _stopped = true;
+    }
+    _connected.notify_all();
+
+    _work.reset();
+    _service.stop();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+
+    // the server's thread is gone, no handler can run anymore
+    std::list<subscriber_ptr> subscribers;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_control) {
+            _commands += _control->commands();
+            _total_latency += _control->meanLatency() * _control->commands();
+            _max_latency = std::max(_max_latency, _control->maxLatency());
+            _control.reset();
+        }
+        _controller.reset();
+        subscribers.swap(_subscribers);
+    }
+    for (auto &subscriber : subscribers) {
+        subscriber->stop();
+        std::lock_guard<std::mutex> lock(_mtx);
+        retire(subscriber);
+    }
+    boost::system::error_code error;
+    _acceptor.close(error);
+    _signals.clear(error);
+    if (_udp) {
+        _udp->close();
+    }
+    if (_shm) {
+        _shm->close();
+    }
+}
+
+bool StreamServer::waitForClient() {
+    std::unique_lock<std::mutex> lock(_mtx);
+    _connected.wait(lock, [this]{ return _stopped || !_subscribers.empty(); });
+    return !_stopped;
+}
+
+bool StreamServer::isStopped() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _stopped;
+}
+
+size_t StreamServer::broadcast(const frame_ptr &frame) {
+    // a lost datagram only costs this frame, the client is not removed for it
+    if (_udp && !frame->buffer.empty()) {
+        // the client matches the frame with its detections by the tag
+        _udp->send(frame->buffer, (uint32_t) frame->id);
+        // the client has joined or lost a frame and starts over
+        if (_udp->joined() && _request_keyframe) {
+            _request_keyframe();
+        }
+    }
+    // the raw frame is written straight into the slot, nothing is written while no client is attached
+    if (_shm && _shm->isOpen() && !frame->image.empty()) {
+        const cv::Mat &image = frame->image;
+        const size_t step = image.cols * image.elemSize();
+        try {
+            unsigned char *slot = _shm->acquire(image.rows * step);
+            cv::Mat raw(image.rows, image.cols, image.type(), slot, step);
+            image.copyTo(raw);
+            _shm->publish(image.rows, image.cols, image.type(), step, frame->id);
+        } catch (std::invalid_argument &ex) {
+            _oversized += 1;
+        }
+    }
+
+    size_t n = 0;
+    std::list<subscriber_ptr> closed;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        for (auto it = _subscribers.begin(); it != _subscribers.end();) {
+            if ((*it)->push(frame)) {
+                n += 1;
+                ++it;
+            } else if (*it != _controller) {
+                // the controlling client is removed once its control channel has noticed
+                closed.push_back(*it);
+                it = _subscribers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (auto &subscriber : closed) {
+        std::cout << "client " << subscriber->id() << " disconnected" << std::endl;
+        subscriber->stop();
+        std::lock_guard<std::mutex> lock(_mtx);
+        retire(subscriber);
+    }
+    return n;
+}
+
+size_t StreamServer::clients() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _subscribers.size();
+}
+
+uint64_t StreamServer::dropped() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    uint64_t dropped = _dropped;
+    for (const auto &subscriber : _subscribers) {
+        dropped += subscriber->dropped();
+    }
+    return dropped;
+}
+
+uint64_t StreamServer::oversized() const {
+    return _oversized;
+}
+
+uint64_t StreamServer::commands() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _commands + (_control ? _control->commands() : 0);
+}
+
+double StreamServer::meanLatency() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    uint64_t n = _commands;
+    double total = _total_latency;
+    if (_control) {
+        n += _control->commands();
+        total += _control->meanLatency() * _control->commands();
+    }
+    return n > 0 ? total / double(n) : 0.0;
+}
+
+uint64_t StreamServer::maxLatency() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return std::max(_max_latency, _control ? _control->maxLatency() : 0);
+}
+
+uint64_t StreamServer::sessions() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _next_id - 1;
+}
+
+double StreamServer::meanTimeToVideo() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _videos > 0 ? double(_total_time_to_video) / double(_videos) : 0.0;
+}
+
+uint64_t StreamServer::maxTimeToVideo() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _max_time_to_video;
+}
+
+void StreamServer::accept() {
+    _acceptor.async_accept(_socket, [this](const boost::system::error_code &error) {
+        if (error) {
+            if (error != boost::asio::error::operation_aborted) {
+                std::cout << error.message() << std::endl;
+                std::cout << "connection failed" << std::endl;
+                accept();
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            if (_subscribers.size() >= _max_clients) {
+                std::cout << "too many clients, connection refused" << std::endl;
+                boost::system::error_code ec;
+                _socket.close(ec);
+            } else {
+                boost::system::error_code ec;
+                const auto remote = _socket.remote_endpoint(ec);
+                if (_subscribers.empty() && _next_id > 1) {
+                    std::cout << "resuming after " << std::chrono::duration_cast<std::chrono::seconds>(
+                            std::chrono::steady_clock::now() - _idle_since).count() << "s without clients" << std::endl;
+                }
+                auto subscriber = std::make_shared<Subscriber>(std::move(_socket), _next_id++, _policy,
+                                                               _transport == Socket::TCP);
+                subscriber->setKeyframeRequest(_request_keyframe);
+                subscriber->start();
+                _subscribers.push_back(subscriber);
+                std::cout << "client " << subscriber->id() << " connected from " << remote << std::endl;
+                if (!_controller) {
+                    grantControl();
+                }
+            }
+        }
+        _connected.notify_all();
+
+        // the moved from socket can be used for the next client
+        accept();
+    });
+}
+
+void StreamServer::grantControl() {
+    // the longest connected client that is still alive
+    const auto it = std::find_if(_subscribers.begin(), _subscribers.end(), [](const subscriber_ptr &subscriber) {
+        return subscriber->isRunning();
+    });
+    if (it == _subscribers.end()) {
+        return;
+    }
+
+    _controller = *it;
+    _controller->setFeedback(_feedback);
+    _control.reset(new ControlChannel(_controller->socket(), _actions));
+    // pings are answered on the same connection the frames are sent on
+    const auto controller = _controller;
+    _control->setOnPing([controller](uint32_t seq, uint64_t timestamp) { controller->pong(seq, timestamp); });
+    _control->start([this] {
+        // the channel is destroyed outside of its own completion handler
+        _service.post([this]{ releaseControl(); });
+    });
+    std::cout << "client " << _controller->id() << " has the control" << std::endl;
+}
+
+void StreamServer::releaseControl() {
+    subscriber_ptr controller;
+    action_t on_control_lost;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (!_control) {
+            return;
+        }
+        _commands += _control->commands();
+        _total_latency += _control->meanLatency() * _control->commands();
+        _max_latency = std::max(_max_latency, _control->maxLatency());
+        _control.reset();
+
+        controller.swap(_controller);
+        controller->setFeedback(feedback_t());
+        _subscribers.remove(controller);
+        on_control_lost = _on_control_lost;
+    }
+
+    // a controller that sent x has ended its session, others have lost their connection
+    controller->stop();
+    std::cout << "client " << controller->id() << " disconnected" << std::endl;
+    if (on_control_lost) {
+        on_control_lost();
+    }
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    retire(controller);
+    grantControl();
+}
+
+void StreamServer::retire(const subscriber_ptr &subscriber) {
+    _dropped += subscriber->dropped();
+    if (subscriber->sent() > 0) {
+        _videos += 1;
+        _total_time_to_video += subscriber->timeToVideo();
+        _max_time_to_video = std::max(_max_time_to_video, subscriber->timeToVideo());
+    }
+    if (_subscribers.empty()) {
+        _idle_since = std::chrono::steady_clock::now();
+    }
+}
@@ -0,0 +1,267 @@
+#ifndef __STREAMSERVER_HPP
+#define __STREAMSERVER_HPP
+
+#include <map>
+#include <list>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+#include <boost/asio.hpp>
+#include <Socket.hpp>
+#include <UdpSender.hpp>
+#include <ShmSender.hpp>
+#include <Subscriber.hpp>
+#include <ControlChannel.hpp>
+
+/***
+ * Accepts any number of clients and fans the encoded video stream out to all
+ * of them, every frame is encoded once and shared by the subscribers.
+ * Only one client holds the control role, its commands are executed and its
+ * link feeds back into the stream quality. If it disconnects, the control role
+ * moves on to the client that has been connected the longest.
+ * Accepting and reading control commands is done on the server's own thread.
+ * The server outlives its clients, after the last one has left it keeps
+ * accepting until it is stopped or the process receives SIGINT or SIGTERM.
+ * The video can be sent over UDP instead, then the clients only get the
+ * detections, telemetry and pongs over TCP and the frames go as datagrams
+ * to the one client that has registered on the UDP port of the same number.
+ * With SHM the raw frames are passed to a client on the same machine through
+ * the shared memory segment of the port, they are not encoded at all.
+ */
+class StreamServer {
+public:
+
+    typedef Subscriber::frame_ptr   frame_ptr;
+
+    typedef Subscriber::feedback_t  feedback_t;
+
+    typedef ControlChannel::action_t action_t;
+
+    /***
+     * create server, it does not accept before start() is called
+     * @param port
+     * @param actions maps control commands to actions
+     */
+    StreamServer(unsigned short port, const std::map<char, action_t> &actions);
+
+    StreamServer(const StreamServer &server) = delete;
+
+    ~StreamServer();
+
+    StreamServer& operator=(const StreamServer &server) = delete;
+
+    /***
+     * set the maximum number of clients, further connections are closed right away
+     * @param n
+     */
+    void setMaxClients(size_t n);
+
+    /***
+     * set how the clients' sockets handle small segments
+     * @param policy
+     */
+    void setPolicy(framing::policy_t policy);
+
+    /***
+     * set the transport of the video, must be called before start()
+     * @param transport TCP, UDP or SHM
+     * @param capacity largest raw frame in bytes, only used by SHM
+     */
+    void setTransport(Socket::transport_t transport, size_t capacity=shared_ring::DEFAULT_CAPACITY);
+
+    /***
+     * set the function that is told about every frame sent to the controlling client
+     * @param feedback
+     */
+    void setFeedback(const feedback_t &feedback);
+
+    /***
+     * set the action that makes the encoder produce a keyframe, it is run when a client
+     * joins or has missed a frame of an inter-frame codec, must be called before start()
+     * @param action called from the server's thread or the thread calling broadcast()
+     */
+    void setKeyframeRequest(const action_t &action);
+
+    /***
+     * set the action that is run whenever the controlling client has left,
+     * e.g. to stop the motors
+     * @param action
+     */
+    void setOnControlLost(const action_t &action);
+
+    /***
+     * start accepting clients on the server's thread
+     */
+    void start();
+
+    /***
+     * disconnect all clients and stop the server's thread
+     */
+    void stop();
+
+    /***
+     * wait until at least one client is connected
+     * @return false if the server has been stopped
+     */
+    bool waitForClient();
+
+    /***
+     * check if the server has been stopped or terminated by a signal
+     * @return
+     */
+    bool isStopped() const;
+
+    /***
+     * send a frame to all clients without blocking, clients whose connection
+     * has failed are removed
+     * @param frame
+     * @return number of clients the frame has been queued for
+     */
+    size_t broadcast(const frame_ptr &frame);
+
+    /***
+     * get the number of connected clients
+     * @return
+     */
+    size_t clients() const;
+
+    /***
+     * get the number of frames dropped because a client's socket was still busy
+     * with an earlier frame, including clients that have disconnected
+     * @return
+     */
+    uint64_t dropped() const;
+
+    /***
+     * get the number of raw frames that did not fit into the shared memory segment
+     * @return
+     */
+    uint64_t oversized() const;
+
+    /***
+     * get the number of control commands of all control sessions
+     * @return
+     */
+    uint64_t commands() const;
+
+    /***
+     * get the mean command-to-actuation latency of all control sessions in usec
+     * @return
+     */
+    double meanLatency() const;
+
+    /***
+     * get the maximum command-to-actuation latency of all control sessions in usec
+     * @return
+     */
+    uint64_t maxLatency() const;
+
+    /***
+     * get the number of clients that have been served
+     * @return
+     */
+    uint64_t sessions() const;
+
+    /***
+     * get the mean time from connecting until the image of the first frame has been sent
+     * in msec, of all clients that have received one, it is only measured over TCP
+     * @return
+     */
+    double meanTimeToVideo() const;
+
+    /***
+     * get the maximum time from connecting until the first frame has been sent in msec
+     * @return
+     */
+    uint64_t maxTimeToVideo() const;
+
+private:
+
+    typedef std::shared_ptr<Subscriber> subscriber_ptr;
+
+    void accept();
+
+    void grantControl();
+
+    void releaseControl();
+
+    void retire(const subscriber_ptr &subscriber);
+
+    boost::asio::io_service _service;
+
+    boost::asio::ip::tcp::acceptor _acceptor;
+
+    boost::asio::ip::tcp::socket _socket;
+
+    std::unique_ptr<boost::asio::io_service::work> _work;
+
+    boost::asio::signal_set _signals;
+
+    std::thread _thread;
+
+    std::map<char, action_t> _actions;
+
+    feedback_t _feedback;
+
+    action_t _on_control_lost;
+
+    action_t _request_keyframe;
+
+    size_t _max_clients = 4;
+
+    framing::policy_t _policy = framing::NODELAY;
+
+    const unsigned short _port;
+
+    Socket::transport_t _transport = Socket::TCP;
+
+    // video sent as datagrams, only used from the thread calling broadcast()
+    std::unique_ptr<UdpSender> _udp;
+
+    // raw video in shared memory, only used from the thread calling broadcast()
+    std::unique_ptr<ShmSender> _shm;
+
+    std::atomic<uint64_t> _oversized{0};
+
+    // connected clients, in the order they have connected
+    std::list<subscriber_ptr> _subscribers;
+
+    mutable std::mutex _mtx;
+
+    std::condition_variable _connected;
+
+    bool _stopped = false;
+
+    // client holding the control role and its channel
+    subscriber_ptr _controller;
+
+    std::unique_ptr<ControlChannel> _control;
+
+    unsigned int _next_id = 1;
+
+    // statistics of clients that have disconnected and control sessions that have ended
+    uint64_t _dropped = 0;
+
+    uint64_t _commands = 0;
+
+    double _total_latency = 0.0;
+
+    uint64_t _max_latency = 0;
+
+    uint64_t _videos = 0;
+
+    uint64_t _total_time_to_video = 0;
+
+    uint64_t _max_time_to_video = 0;
+
+    // time the last client has left
+    std::chrono::steady_clock::time_point _idle_since;
+
+};
+
+#endif // __STREAMSERVER_HPP
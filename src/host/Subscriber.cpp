@@ -0,0 +1,229 @@
+#include <Subscriber.hpp>
+#include <QualityController.hpp>
+#include <stats.hpp>
+#include <iostream>
+
+Subscriber::Subscriber(boost::asio::ip::tcp::socket &&socket, unsigned int id, framing::policy_t policy, bool video) :
+        _socket(std::move(socket)), _id(id), _policy(policy), _video(video), _writer(policy),
+        _connected(std::chrono::steady_clock::now()) {
+    try {
+        framing::set_policy(_socket, _policy);
+    } catch (std::exception &ex) {
+        // a broken connection is noticed with the first write
+        std::cout << "client " << _id << ": " << ex.what() << std::endl;
+    }
+}
+
+Subscriber::~Subscriber() {
+    stop();
+    boost::system::error_code error;
+    _socket.close(error);
+}
+
+void Subscriber::start(const action_t &on_close) {
+    _on_close = on_close;
+    _running = true;
+}
+
+bool Subscriber::push(const frame_ptr &frame) {
+    if (!_running) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_pending_mtx);
+        if (_pending) {
+            // the replaced frame is never sent, later frames of an inter-frame codec cannot be decoded
+            _synced = false;
+            // the client has not taken the previous frame yet, without a write in progress
+            // it is only replaced before the posted next() has run
+            if (_busy) {
+                _dropped += 1;
+            }
+        }
+        _pending = frame;
+    }
+    // the socket is only written from the server's thread
+    auto self = shared_from_this();
+    boost::asio::post(_socket.get_executor(), [self]{ self->next(); });
+    return true;
+}
+
+void Subscriber::setFeedback(const feedback_t &feedback) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _feedback = feedback;
+}
+
+void Subscriber::setKeyframeRequest(const action_t &action) {
+    _request_keyframe = action;
+}
+
+void Subscriber::pong(uint32_t seq, uint64_t timestamp) {
+    {
+        std::lock_guard<std::mutex> lock(_pending_mtx);
+        _pong = true;
+        _pong_seq = seq;
+        _pong_timestamp = timestamp;
+    }
+    next();
+}
+
+void Subscriber::stop() {
+    _running = false;
+    {
+        std::lock_guard<std::mutex> lock(_pending_mtx);
+        _pending.reset();
+    }
+    // a write in progress completes with an error
+    boost::system::error_code error;
+    _socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+}
+
+bool Subscriber::isRunning() const {
+    return _running;
+}
+
+boost::asio::ip::tcp::socket& Subscriber::socket() {
+    return _socket;
+}
+
+unsigned int Subscriber::id() const {
+    return _id;
+}
+
+uint64_t Subscriber::sent() const {
+    return _sent;
+}
+
+uint64_t Subscriber::dropped() const {
+    return _dropped;
+}
+
+uint64_t Subscriber::timeToVideo() const {
+    return _time_to_video;
+}
+
+void Subscriber::next() {
+    if (_busy || !_running) {
+        return;
+    }
+    frame_ptr frame;
+    bool pong = false;
+    uint32_t pong_seq = 0;
+    uint64_t pong_timestamp = 0;
+    {
+        // pong() may be called again as soon as the lock is released
+        std::lock_guard<std::mutex> lock(_pending_mtx);
+        frame.swap(_pending);
+        std::swap(pong, _pong);
+        pong_seq = _pong_seq;
+        pong_timestamp = _pong_timestamp;
+    }
+    if (!frame && !pong) {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    _writer.clear();
+    if (pong) {
+        _writer.reply(protocol::PONG, pong_seq, pong_timestamp);
+    }
+    bool video = false;
+    if (frame) {
+        if (now - _last_telemetry >= std::chrono::seconds(1)) {
+            addTelemetry(now);
+        }
+        // the capture time is sent as wall clock time
+        const uint64_t captured = protocol::now() - std::chrono::duration_cast<std::chrono::microseconds>(
+                now - frame->timestamp).count();
+        // the predictions are sent ahead of the image they belong to
+        _writer.add(protocol::DETECTION_LIST, frame->detections, captured);
+        video = _video && !frame->buffer.empty() && addVideo(*frame, captured);
+    }
+
+    // the frame is kept alive until its buffers have been written
+    _busy = true;
+    _writing = std::move(frame);
+    _writing_video = video;
+    _write_begin = now;
+    auto self = shared_from_this();
+    _writer.async_write(_socket, [self](const boost::system::error_code &error, size_t bytes) {
+        self->written(error, bytes);
+    });
+}
+
+void Subscriber::written(const boost::system::error_code &error, size_t bytes) {
+    _busy = false;
+    const frame_ptr frame = std::move(_writing);
+    _writing.reset();
+    if (error) {
+        if (_running) {
+            std::cout << "client " << _id << ": " << error.message() << std::endl;
+        }
+        close();
+        return;
+    }
+
+    // writes of only detections and pongs tell nothing about the video
+    if (frame && _writing_video) {
+        const uint64_t send_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - _write_begin).count();
+        if (_sent++ == 0) {
+            _time_to_video = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - _connected).count();
+            std::cout << "client " << _id << ": first frame sent " << _time_to_video << "ms after connecting" << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_feedback) {
+            _feedback(bytes, send_time, QualityController::queued(_socket.native_handle()));
+        }
+    }
+
+    // the frame that has arrived meanwhile
+    next();
+}
+
+void Subscriber::close() {
+    // nothing can be sent anymore, a pending read on the socket fails as well
+    if (_running.exchange(false)) {
+        boost::system::error_code error;
+        _socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+        {
+            std::lock_guard<std::mutex> lock(_pending_mtx);
+            _pending.reset();
+        }
+        if (_on_close) {
+            _on_close();
+        }
+    }
+}
+
+bool Subscriber::addVideo(const Frame &frame, uint64_t captured) {
+    if (frame.keyframe) {
+        _synced = true;
+        _keyframe_requested = false;
+    }
+    if (!_synced) {
+        // the detections are still sent, the video resumes with the keyframe
+        if (!_keyframe_requested && _request_keyframe) {
+            _request_keyframe();
+            _keyframe_requested = true;
+        }
+        return false;
+    }
+    _writer.add(frame.codec == VideoEncoder::VP8 ? protocol::VP8_FRAME : protocol::JPEG_FRAME, frame.buffer, captured);
+    return true;
+}
+
+void Subscriber::addTelemetry(std::chrono::steady_clock::time_point now) {
+    _telemetry.jpeg_quality = (float) stats::get(stats::JPEG_QUALITY);
+    _telemetry.width = (uint32_t) stats::get(stats::STREAM_WIDTH);
+    _telemetry.height = (uint32_t) stats::get(stats::STREAM_HEIGHT);
+    _telemetry.link_latency = (float) stats::get(stats::LINK_LATENCY);
+    _telemetry.link_rate = (float) stats::get(stats::LINK_RATE);
+    _telemetry.sent = (uint32_t) _sent;
+    _telemetry.dropped = (uint32_t) _dropped;
+    protocol::swap_batch(&_telemetry, 1);
+    _writer.add(protocol::STATS, &_telemetry, sizeof(_telemetry));
+    _last_telemetry = now;
+}
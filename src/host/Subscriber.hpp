@@ -0,0 +1,208 @@
+#ifndef __SUBSCRIBER_HPP
+#define __SUBSCRIBER_HPP
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <boost/asio.hpp>
+#include <Framing.hpp>
+#include <Protocol.hpp>
+#include <Frame.hpp>
+
+/***
+ * A client connected to the StreamServer that receives the video stream.
+ * Frames are encoded once and shared between all subscribers. Sending never
+ * blocks: frames are written asynchronously on the server's io_service and
+ * while a frame is still draining into a slow client's socket, the newest
+ * frame waits in a single pending slot, a frame already waiting there is
+ * replaced and counted as dropped if a write is still in progress. So a slow client never stalls the
+ * pipeline, the other clients or the control channel.
+ * Every frame goes out as a detection list and a JPEG or VP8 frame message, once
+ * per second they are preceded by the telemetry of the host. If the video is sent
+ * over another transport, only the detection list is sent for a frame.
+ * Frames of an inter-frame codec can only be decoded after a keyframe and as long
+ * as none has been left out, a client that has just joined or missed a frame gets
+ * no video until the next keyframe, which it asks the encoder for.
+ */
+class Subscriber : public std::enable_shared_from_this<Subscriber> {
+public:
+
+    typedef std::shared_ptr<const Frame>    frame_ptr;
+
+    typedef std::function<void (void)>      action_t;
+
+    // called after the image of a frame has been sent with the size in bytes, the time the send took in usec
+    // and the number of bytes still queued in the socket
+    typedef std::function<void (size_t, uint64_t, long)>   feedback_t;
+
+    /***
+     * create subscriber for a connected client, it must be owned by a shared_ptr
+     * @param socket
+     * @param id number of the client, used in messages
+     * @param policy how the socket handles small segments
+     * @param video false if the frames are sent over another transport
+     */
+    Subscriber(boost::asio::ip::tcp::socket &&socket, unsigned int id, framing::policy_t policy=framing::NODELAY,
+               bool video=true);
+
+    Subscriber(const Subscriber &subscriber) = delete;
+
+    ~Subscriber();
+
+    Subscriber& operator=(const Subscriber &subscriber) = delete;
+
+    /***
+     * start sending
+     * @param on_close called from the server's thread if sending failed
+     */
+    void start(const action_t &on_close=action_t());
+
+    /***
+     * send a frame, if the previous one is still being sent it waits in the pending slot
+     * and replaces the frame waiting there
+     * @param frame
+     * @return false if the subscriber has been stopped
+     */
+    bool push(const frame_ptr &frame);
+
+    /***
+     * set the function that is told about every frame sent
+     * @param feedback empty to disable
+     */
+    void setFeedback(const feedback_t &feedback);
+
+    /***
+     * set the action that makes the encoder produce a keyframe, must be set before start()
+     * @param action called from the server's thread
+     */
+    void setKeyframeRequest(const action_t &action);
+
+    /***
+     * answer a ping of the client, is sent with the next write, must be called from the server's thread
+     * @param seq
+     * @param timestamp
+     */
+    void pong(uint32_t seq, uint64_t timestamp);
+
+    /***
+     * stop sending and shut the connection down, a write in progress fails
+     */
+    void stop();
+
+    bool isRunning() const;
+
+    boost::asio::ip::tcp::socket& socket();
+
+    unsigned int id() const;
+
+    /***
+     * get the number of frames whose image has been sent, the detections of frames sent
+     * while waiting for a keyframe or over another transport are not counted
+     * @return
+     */
+    uint64_t sent() const;
+
+    /***
+     * get the number of frames dropped because the client's socket was still busy
+     * with an earlier frame
+     * @return
+     */
+    uint64_t dropped() const;
+
+    /***
+     * get the time from connecting until the image of the first frame has been sent in msec
+     * @return 0 if no image has been sent yet, which is always the case if the video is
+     *         sent over another transport, see sent()
+     */
+    uint64_t timeToVideo() const;
+
+private:
+
+    /***
+     * start writing the pending frame and pong, if there is no write in progress,
+     * only called from the server's thread
+     */
+    void next();
+
+    void written(const boost::system::error_code &error, size_t bytes);
+
+    void close();
+
+    /***
+     * add the compressed image of a frame unless the client has to wait for a keyframe
+     * @param frame
+     * @param captured capture time as wall clock time
+     * @return true if the image has been added
+     */
+    bool addVideo(const Frame &frame, uint64_t captured);
+
+    void addTelemetry(std::chrono::steady_clock::time_point now);
+
+    boost::asio::ip::tcp::socket _socket;
+
+    const unsigned int _id;
+
+    framing::policy_t _policy;
+
+    const bool _video;
+
+    // messages of the write in progress, only used from the server's thread
+    protocol::Writer _writer;
+
+    protocol::Telemetry _telemetry;
+
+    std::chrono::steady_clock::time_point _last_telemetry;
+
+    std::atomic_bool _running { false };
+
+    action_t _on_close;
+
+    // frame waiting for the write in progress and the pong to send with it
+    std::mutex _pending_mtx;
+
+    frame_ptr _pending;
+
+    bool _pong = false;
+
+    uint32_t _pong_seq = 0;
+
+    uint64_t _pong_timestamp = 0;
+
+    // the client can decode the next frame of an inter-frame codec
+    std::atomic_bool _synced { false };
+
+    // a keyframe has been requested and not been sent yet, only used from the server's thread
+    bool _keyframe_requested = false;
+
+    action_t _request_keyframe;
+
+    // frame of the write in progress, its buffers are written from
+    frame_ptr _writing;
+
+    // the write in progress carries the image of the frame
+    bool _writing_video = false;
+
+    // read by push() from the pipeline's thread
+    std::atomic_bool _busy { false };
+
+    std::chrono::steady_clock::time_point _write_begin;
+
+    std::mutex _mtx;
+
+    feedback_t _feedback;
+
+    std::atomic<uint64_t> _sent { 0 };
+
+    std::atomic<uint64_t> _dropped { 0 };
+
+    std::atomic<uint64_t> _time_to_video { 0 };
+
+    // time the client has connected
+    const std::chrono::steady_clock::time_point _connected;
+
+};
+
+#endif // __SUBSCRIBER_HPP
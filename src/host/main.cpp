@@ -1,32 +1,37 @@
 #include <iostream>
 #include <map>
 #include <atomic>
+#include <thread>
+#include <future>
+#include <mutex>
 #include <functional>
 #include <vector>
 #include <string>
+#include <memory>
+#include <algorithm>
 #include <opencv2/opencv.hpp>
-#include <boost/asio.hpp>
 #include <L298NHBridge.hpp>
 #include <common.hpp>
 #include <config.hpp>
 #include <ObjectDetector.hpp>
+#include <BoundedQueue.hpp>
+#include <Frame.hpp>
+#include <FrameGrabber.hpp>
+#include <StreamServer.hpp>
+#include <ScopedTimer.hpp>
+#include <stats.hpp>
+#include <InferenceStage.hpp>
+#include <DetectorPool.hpp>
+#include <ModelSwitcher.hpp>
+#include <DetectionMessage.hpp>
+#include <QualityController.hpp>
 #include <fstream>
 
-using boost::asio::ip::tcp;
 using namespace cv;
 using namespace cv::dnn;
 
-#define SEND(sck, ptr, n, err)  if (sck.is_open()) { \
-                                    boost::asio::write(sck, boost::asio::buffer(ptr, n), err); \
-                                    if (err) \
-                                        std::cout << err.message() << std::endl; \
-                                }
-
-#define RECV(sck, ptr, n, err)  if (sck.is_open()) { \
-                                    boost::asio::read(sck, boost::asio::buffer(ptr, n), err); \
-                                    if (err) \
-                                        std::cout << err.message() << std::endl; \
-                                }
+// deeper queues only add latency, every frame waits behind the ones queued before it
+static const unsigned int MAX_QUEUE_DEPTH = 64;
 
 int main(int argc, const char *argv[]) {
     const std::vector<std::string> args(argv, argv + argc);
@@ -52,6 +57,24 @@ int main(int argc, const char *argv[]) {
     const int height = config::get_as<int>("HEIGHT");
     const int r_speed = config::get_as<int>("ROTATION_SPEED");
     const int d_speed = config::get_as<int>("DRIVE_SPEED");
+    const std::string camera_backend = config::get_or_default<std::string>("CAMERA_BACKEND", "OPENCV");
+    const auto transport = Socket::transport_from_string(config::get_or_default<std::string>("STREAM_TRANSPORT", "TCP"));
+    const auto codec = VideoEncoder::codec_from_string(config::get_or_default<std::string>("STREAM_CODEC", "JPEG"));
+    if (!VideoEncoder::available(codec)) {
+        std::cout << "video codec not available" << std::endl;
+        exit(1);
+    }
+
+    // pipeline parameters, every stage runs on its own thread and hands
+    // frames on through a bounded queue, so throughput is set by the slowest stage
+    // a negative depth wraps around when read as unsigned and is rejected by the upper bound
+    const auto queue_depth = config::get_or_default<unsigned int>("QUEUE_DEPTH", 2);
+    if (queue_depth == 0 || queue_depth > MAX_QUEUE_DEPTH) {
+        std::cout << "QUEUE_DEPTH must be between 1 and " << MAX_QUEUE_DEPTH << std::endl;
+        exit(1);
+    }
+    const auto drop_policy = BoundedQueue<Frame>::policy_from_string(
+            config::get_or_default<std::string>("DROP_POLICY", "DROP_OLDEST"));
 
     // L298N H-Bridge pins
     const int ENA = config::get_as<int>("ENA");
@@ -62,48 +85,34 @@ int main(int argc, const char *argv[]) {
     const int ENB = config::get_as<int>("ENB");
 
     // object detector parameters
+    // the networks listed in NETS can be switched between at runtime, NET is loaded first
     const std::string net = config::get("NET");
-    const std::string model = config::get(net + "_MODEL");
-    const std::string config = config::get(net + "_CONFIG");
-    const std::string framework = config::get_or_default<std::string>(net + "_FRAMEWORK", "");
-    const float scale = config::get_or_default(net  + "_SCALE", 1.0f);
+    std::vector<std::string> nets;
+    for (const auto &name : string::split(config::get_or_default<std::string>("NETS", net), ",")) {
+        if (!string::trim(name).empty()) {
+            nets.push_back(string::trim(name));
+        }
+    }
+    auto net_index = std::find_if(nets.begin(), nets.end(), [&](const std::string &name) {
+        return string::iequals(name, net);
+    }) - nets.begin();
+    if (net_index == (long) nets.size()) {
+        nets.insert(nets.begin(), net);
+        net_index = 0;
+    }
     const int backend = config::get_or_default<int>("BACKEND", 0);
     const int target = config::get_or_default<int>("TARGET", 0);
     const auto threshold = config::get_as<float>("THRESHOLD");
     const auto nms_threshold = config::get_as<float>("NMS_THRESHOLD");
+    const int nms_top_k = config::get_or_default<int>("NMS_TOP_K", 0);
+    const auto soft_nms_sigma = config::get_or_default<float>("SOFT_NMS_SIGMA", 0.0f);
     const int ddepth = config::get_or_default<int>("DEPTH", 0);
+    const int input_width = config::get_or_default<int>("INPUT_WIDTH", 320);
+    const int input_height = config::get_or_default<int>("INPUT_HEIGHT", 320);
+    const auto detectors = config::get_or_default<unsigned int>("DETECTORS", 1);
 
     std::cout << "Object Detector: " << net << std::endl;
 
-    // setup H-Bridge
-    L298NHBridge bridge(ENA, IN1, IN2, IN3, IN4, ENB);
-
-    // open camera
-    cv::VideoCapture camera(0);
-    if (!camera.isOpened()) {
-        std::cout << "unable to access camera" << std::endl;
-        exit(1);
-    }
-
-    // set camera properties
-    camera.set(cv::CAP_PROP_FRAME_WIDTH, width);
-    camera.set(cv::CAP_PROP_FRAME_HEIGHT, height);
-
-    std::cout << "frame width=" << camera.get(cv::CAP_PROP_FRAME_WIDTH) << std::endl
-                << "frame_height=" << camera.get(cv::CAP_PROP_FRAME_HEIGHT) << std::endl
-                << "camera FPS=" << camera.get(cv::CAP_PROP_FPS) << std::endl;
-
-    // load object detector
-    ObjectDetector detector;
-    detector.readNet(model, config, framework);
-    detector.getNet().setPreferableBackend(backend);
-    detector.getNet().setPreferableTarget(target);
-    detector.setConfidenceThreshold(threshold);
-    detector.setNMSThreshold(nms_threshold);
-    detector.setCrop(true);
-    detector.setScale(scale);
-    detector.setDDepth(ddepth);
-
     // check if list of classes can be loaded
     std::vector<std::string> classes;
     std::ifstream file(config::get("CLASSES"));
@@ -115,24 +124,120 @@ int main(int argc, const char *argv[]) {
         file.close();
     }
 
-    detector.setClasses(classes);
+    // every detector is configured the same way and warmed up
+    // before a client is accepted, the first passes are much slower
+    const auto warmup_runs = config::get_or_default<unsigned int>("WARMUP_RUNS", 2);
 
-    // setup boost socket
-    boost::asio::io_service io_service;
-    tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port));
-    tcp::socket socket(io_service);
+    // time a network took to load and to warm up in msec, summed over the detectors of a pool
+    struct LoadTimes {
 
-    // connect to client
-    std::cout << "listening on port " << port << std::endl;
-    std::cout << "waiting for connection..." << std::endl;
+        uint64_t load = 0;
+
+        uint64_t warmup = 0;
+
+    };
+    const auto setup_detector = [&](ObjectDetector &detector, const std::string &name) {
+        const auto begin = std::chrono::steady_clock::now();
+        detector.readNet(config::get(name + "_MODEL"), config::get(name + "_CONFIG"),
+                         config::get_or_default<std::string>(name + "_FRAMEWORK", ""));
+        detector.getNet().setPreferableBackend(backend);
+        detector.getNet().setPreferableTarget(target);
+        detector.setConfidenceThreshold(threshold);
+        detector.setNMSThreshold(nms_threshold);
+        detector.setTopK(nms_top_k);
+        detector.setSoftNMS(soft_nms_sigma);
+        detector.setCrop(true);
+        detector.setScale(config::get_or_default(name + "_SCALE", 1.0f));
+        detector.setDDepth(ddepth);
+        detector.setSize(cv::Size(input_width, input_height));
+        detector.setLetterbox(true);
+        detector.setClasses(classes);
+
+        const auto loaded = std::chrono::steady_clock::now();
+        detector.warmup(warmup_runs);
+        const auto warm = std::chrono::steady_clock::now();
+        LoadTimes times;
+        times.load = std::chrono::duration_cast<std::chrono::milliseconds>(loaded - begin).count();
+        times.warmup = std::chrono::duration_cast<std::chrono::milliseconds>(warm - loaded).count();
+        return times;
+    };
+    const auto create_detector = [&](const std::string &name, LoadTimes &times) {
+        std::shared_ptr<ObjectDetector> detector(new ObjectDetector);
+        times = setup_detector(*detector, name);
+        return detector;
+    };
+    const auto create_pool = [&](const std::string &name, LoadTimes &times) {
+        std::shared_ptr<DetectorPool> pool(new DetectorPool);
+        // the detectors are set up one after another on the calling thread
+        pool->open(detectors, [&](ObjectDetector &detector) {
+            const LoadTimes detector_times = setup_detector(detector, name);
+            times.load += detector_times.load;
+            times.warmup += detector_times.warmup;
+        });
+        return pool;
+    };
+
+    // with more than one detector frames are detected concurrently by a pool and tracking is not used
+    // networks switched to at runtime are loaded on the switcher's thread, which reports their time itself
+    ModelSwitcher<ObjectDetector> models(nets, [&](const std::string &name) {
+        LoadTimes times;
+        return create_detector(name, times);
+    });
+    ModelSwitcher<DetectorPool> pools(nets, [&](const std::string &name) {
+        LoadTimes times;
+        return create_pool(name, times);
+    });
+
+    // load object detector in the background while camera and H-Bridge are set up
+    const auto startup = std::chrono::steady_clock::now();
+    auto loading = std::async(std::launch::async, [&] {
+        LoadTimes times;
+        if (detectors > 1) {
+            pools.load(net_index, create_pool(nets[net_index], times));
+        } else {
+            models.load(net_index, create_detector(nets[net_index], times));
+        }
+        return times;
+    });
+
+    // setup H-Bridge
+    L298NHBridge bridge(ENA, IN1, IN2, IN3, IN4, ENB);
+
+    // open camera, images are grabbed on a separate thread and only the newest one is kept
+    // the V4L2 backend converts straight from the driver's buffers instead of going through OpenCV
+    FrameGrabber grabber;
+    bool camera_opened = false;
+    if (string::iequals(camera_backend, "V4L2")) {
+        camera_opened = grabber.open(config::get_or_default<std::string>("CAMERA_DEVICE", "/dev/video0"), width, height,
+                                     V4L2Capture::format_from_string(config::get_or_default<std::string>("PIXEL_FORMAT", "YUYV")),
+                                     config::get_or_default<unsigned int>("CAMERA_BUFFERS", 4));
+    } else {
+        camera_opened = grabber.open(config::get_or_default<int>("CAMERA", 0), width, height);
+    }
+    if (!camera_opened) {
+        std::cout << "unable to access camera" << std::endl;
+        loading.wait();
+        exit(1);
+    }
+
+    std::cout << "frame width=" << grabber.getSize().width << std::endl
+                << "frame_height=" << grabber.getSize().height << std::endl
+                << "camera FPS=" << grabber.getFPS() << std::endl;
+
+    LoadTimes load_times;
     try {
-        acceptor.accept(socket);
+        load_times = loading.get();
     } catch (std::exception &ex) {
         std::cout << ex.what() << std::endl;
-        std::cout << "connection failed" << std::endl;
+        std::cout << "unable to load object detector" << std::endl;
         exit(1);
     }
-    std::cout << "connection established" << std::endl;
+    if (detectors > 1) {
+        std::cout << "detector pool of " << pools.get()->size() << " detectors" << std::endl;
+    }
+    std::cout << "detector load=" << load_times.load << "ms warm-up=" << load_times.warmup << "ms (" << warmup_runs
+                << " runs) startup=" << std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - startup).count() << "ms" << std::endl;
 
     // map keyboard inputs to actions for host
 	const std::map<char, std::function<void (void)>> actions = {
@@ -140,74 +245,265 @@ int main(int argc, const char *argv[]) {
             { 'w', [&]{ bridge.set_motors(-d_speed, d_speed); }},
             { 's', [&]{ bridge.set_motors(d_speed, -d_speed); }},
             { 'a', [&]{ bridge.set_motors(r_speed, r_speed); }},
-            { 'd', [&]{ bridge.set_motors(-r_speed, -r_speed); }}
+            { 'd', [&]{ bridge.set_motors(-r_speed, -r_speed); }},
+            { 'n', [&]{ if (detectors > 1) pools.next(); else models.next(); }}
 	};
 
-    char c = 0x00;
-    cv::Mat frame(width, height, CV_8SC3);
-    std::vector<unsigned char> buffer(width * height * 3);
-    boost::system::error_code error;
-
-    // main control loop
-	do {
-	    const std::chrono::system_clock::time_point begin = std::chrono::system_clock::now();
-	    // read controls if available
-	    if (socket.available()) {
-            RECV(socket, &c, 1, error);
-            if (error) {
-                std::cout << "unable to read data from socket" << std::endl;
-                break;
-            } else {
-                if (c == 'x') {
-                    std::cout << "connection terminated by peer" << std::endl;
-                    break;
-                } else {
-                    const auto it = actions.find(c);
-                    if (it != actions.end()) {
-                        const auto &func = it->second;
-                        func();
-                    } else {
-                        std::cout << "unrecognized action \'" << c << '\'' << std::endl;
-                    }
-                }
+    // clients are accepted on the server's thread, every client gets the stream and the
+    // first one to connect gets the control, the motors are stopped whenever it leaves
+    // the host keeps running between sessions until it receives SIGINT or SIGTERM
+    StreamServer server(port, actions);
+    server.setMaxClients(config::get_or_default<size_t>("MAX_CLIENTS", 4));
+    server.setPolicy(framing::policy_from_string(config::get_or_default<std::string>("TCP_POLICY", "NODELAY")));
+    // frames are scaled to WIDTH x HEIGHT before they are streamed, the shared memory slots hold one BGR frame
+    server.setTransport(transport, (size_t) width * height * 3);
+    server.setOnControlLost([&]{ bridge.stop_motors(); });
+    // taken by the encode stage with the next frame
+    std::atomic_bool keyframe_requested(false);
+    server.setKeyframeRequest([&]{ keyframe_requested = true; });
+    server.start();
+
+    std::cout << "listening on port " << port << std::endl;
+    std::cout << "waiting for connection..." << std::endl;
+
+    BoundedQueue<Frame> detected(queue_depth, drop_policy);
+    // a frame of an inter-frame codec dropped after encoding breaks the stream of every client
+    BoundedQueue<Frame> encoded(queue_depth, codec == VideoEncoder::JPEG || transport == Socket::SHM ? drop_policy
+                                                                                                 : BoundedQueue<Frame>::BLOCK);
+
+    // frames submitted to the detector pool, in submission order
+    struct Pending {
+
+        Frame frame;
+
+        std::future<DetectorPool::Result> result;
+
+    };
+    BoundedQueue<Pending> in_flight(std::max(1u, detectors), BoundedQueue<Pending>::BLOCK);
+    uint64_t pool_detections = 0;
+
+    std::atomic_bool running(true);
+
+    // periodically dump per-stage latencies
+    stats::start_reporter(config::get_or_default<unsigned int>("STATS_INTERVAL", 0),
+                          config::get_or_default<std::string>("STATS_FILE", ""));
+
+    // stop all stages, blocked stages are woken up by closing their queues
+    const auto shutdown = [&] {
+        running = false;
+        grabber.close();
+        in_flight.close();
+        detected.close();
+        encoded.close();
+    };
+
+    // the detector is run every DETECT_INTERVAL frames or as often as DETECT_BUDGET allows,
+    // in between boxes are propagated with sparse optical flow
+    InferenceStage inference(models);
+    inference.setDetectInterval(config::get_or_default<unsigned int>("DETECT_INTERVAL", 1));
+    inference.setDetectBudget(config::get_or_default<double>("DETECT_BUDGET", 0.0));
+    inference.setMinTrackedFraction(config::get_or_default<double>("TRACK_MIN_FRACTION", 0.5));
+    inference.getTracker().setScale(config::get_or_default<double>("TRACK_SCALE", 0.5));
+
+    // static scenes reuse the previous predictions instead of running the detector
+    inference.setMotionGate(config::get_or_default<bool>("MOTION_GATE", false));
+    inference.getMotionGate().setThreshold(config::get_or_default<double>("MOTION_THRESHOLD", 12.0));
+    inference.getMotionGate().setMaxSkip(config::get_or_default<unsigned int>("MOTION_MAX_SKIP", 30));
+
+    // predictions are sent alongside every frame and drawn by the client,
+    // drawing them into the image on the host as well is optional
+    const bool draw_predictions = config::get_or_default<bool>("DRAW_PREDICTIONS", false);
+
+    // hand the frame on to the encoder
+    const auto finish = [&](Frame &&frame) {
+        if (draw_predictions) {
+            ScopedTimer timer(stats::histogram(stats::DRAW));
+            drawPredictions(frame.image, frame.predictions);
+        }
+
+        if (frame.image.cols != width || frame.image.rows != height) {
+            // predictions are sent in the coordinates of the scaled image
+            scalePredictions(frame.predictions, (double) width / frame.image.cols, (double) height / frame.image.rows);
+            cv::resize(frame.image, frame.image, cv::Size(width, height));
+        }
+        detected.push(std::move(frame));
+    };
+
+    // capture and inference idle while no client is connected, camera and detector stay ready
+    // idle tells if the pipeline has been idle, false is returned once the server has been stopped
+    const auto wait_for_client = [&](bool &idle) {
+        idle = server.clients() == 0;
+        return !idle || server.waitForClient();
+    };
+
+    // take the newest camera image
+    const auto read_frame = [&](Frame &frame) {
+        FrameGrabber::Capture capture;
+        if (!running || !grabber.read(capture)) {
+            return false;
+        }
+        frame.id = capture.id;
+        frame.timestamp = capture.timestamp;
+        frame.image = capture.image;
+        stats::record(stats::CAPTURE, std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - capture.timestamp).count());
+        return true;
+    };
+
+    std::thread inference_thread;
+    std::thread collect_thread;
+    if (detectors > 1) {
+        // submit every frame to the pool, several frames are detected at once
+        inference_thread = std::thread([&] {
+            Pending pending;
+            bool idle = false;
+            while (wait_for_client(idle) && read_frame(pending.frame)) {
+                pending.result = pools.get()->submit(pending.frame.image);
+                in_flight.push(std::move(pending));
+                pending = Pending();
             }
-	    }
+            in_flight.close();
+        });
 
-	    if (!camera.read(frame)) {
-	        std::cout << "cannot acquire camera image" << std::endl;
-	        break;
-	    }
+        // wait for the predictions in the order the frames were submitted
+        collect_thread = std::thread([&] {
+            Pending pending;
+            while (in_flight.pop(pending)) {
+                try {
+                    auto result = pending.result.get();
+                    stats::record(stats::PREPROCESS, result.preprocess_time);
+                    stats::record(stats::FORWARD, result.forward_time);
+                    stats::record(stats::POSTPROCESS, result.postprocess_time);
+                    pending.frame.predictions = std::move(result.predictions);
+                    pool_detections += 1;
+                } catch (std::exception &ex) {
+                    std::cout << ex.what() << std::endl;
+                }
+                finish(std::move(pending.frame));
+            }
+            detected.close();
+        });
+    } else {
+        // inference stage, always works on the newest camera image
+        inference_thread = std::thread([&] {
+            Frame frame;
+            bool idle = false;
+            while (wait_for_client(idle) && read_frame(frame)) {
+                // the scene has changed while there was no client
+                if (idle) {
+                    inference.reset();
+                }
+                // predictions are either detected or tracked, in frame coordinates
+                inference.process(frame);
+                finish(std::move(frame));
+                frame = Frame();
+            }
+            detected.close();
+        });
+    }
 
-	    cv::resize(frame, frame, cv::Size(320, 320));
+    // JPEG quality and resolution follow the throughput of the link to hold TARGET_LATENCY,
+    // 0 streams at the maximum quality and full resolution
+    const auto target_latency = config::get_or_default<double>("TARGET_LATENCY", 0.0);
+    QualityController quality;
+    quality.setQualityRange(config::get_or_default<int>("JPEG_QUALITY_MIN", 30),
+                            config::get_or_default<int>("JPEG_QUALITY_MAX", 90));
+    quality.setStrips(config::get_or_default<unsigned int>("JPEG_STRIPS", 1));
+    if (target_latency > 0.0) {
+        quality.setTargetLatency(target_latency);
+        quality.setMinScale(config::get_or_default<double>("MIN_STREAM_SCALE", 0.5));
+    }
 
-	    std::vector<Prediction> pred = detector.run(frame);
-        drawPredictions(frame, pred);
+    // inter-frame codecs hold STREAM_BITRATE in kbit/s and encode at full resolution
+    const auto encoder = VideoEncoder::create(codec, quality, config::get_or_default<unsigned int>("STREAM_BITRATE", 1000));
 
-        cv::resize(frame, frame, cv::Size(320, 240));
+    // encode stage
+    std::thread encode_thread([&] {
+        Frame frame;
+        while (detected.pop(frame)) {
+            {
+                ScopedTimer timer(stats::histogram(stats::ENCODE));
+                cv::Size size(frame.image.cols, frame.image.rows);
+                // the raw frame is passed on as it is over shared memory, only the detections are serialized
+                if (transport != Socket::SHM) {
+                    if (keyframe_requested.exchange(false)) {
+                        encoder->requestKeyframe();
+                    }
+                    encoder->encode(frame.image, frame.buffer);
+                    size = encoder->size();
+                    if (codec == VideoEncoder::JPEG) {
+                        stats::set(stats::JPEG_QUALITY, quality.encodedQuality());
+                    }
+                }
+                frame.codec = codec;
+                frame.keyframe = transport == Socket::SHM || encoder->keyframe();
+                if (size.width != frame.image.cols || size.height != frame.image.rows) {
+                    scalePredictions(frame.predictions, (double) size.width / frame.image.cols,
+                                     (double) size.height / frame.image.rows);
+                }
+                detection_message::serialize(frame.id, frame.predictions, frame.detections);
+                stats::set(stats::STREAM_WIDTH, size.width);
+                stats::set(stats::STREAM_HEIGHT, size.height);
+            }
+            encoded.push(std::move(frame));
+        }
+        encoded.close();
+    });
 
-        // send frame over getNetwork
-	    uint32_t n = 0;
-	    cv::imencode(".jpeg", frame, buffer);
+    // the link of the controlling client determines the JPEG quality,
+    // only if the frames are sent over its connection
+    std::mutex feedback_mtx;
+    server.setFeedback([&](size_t bytes, uint64_t send_time, long queued) {
+        std::lock_guard<std::mutex> lock(feedback_mtx);
+        stats::record(stats::SEND, send_time);
+        if (target_latency > 0.0 && transport == Socket::TCP && codec == VideoEncoder::JPEG) {
+            quality.update(bytes, send_time, queued);
+            stats::set(stats::LINK_LATENCY, quality.latency());
+            stats::set(stats::LINK_RATE, quality.rate() / 1000.0);
+        }
+    });
 
-	    n = htonl((uint32_t) buffer.size());
-	    SEND(socket, &n, sizeof(n), error);
-	    if (error) {
-	        break;
-	    }
-	    SEND(socket, buffer.data(), buffer.size(), error);
-	    if (error) {
-	        break;
-	    }
+    // fan out stage, the encoded frame is shared by all clients and the image is only needed
+    // for shared memory, frames still in the pipeline when the last client has left are dropped
+    Frame frame;
+    while (encoded.pop(frame) && !server.isStopped()) {
+        if (transport != Socket::SHM) {
+            frame.image.release();
+        }
+        server.broadcast(std::make_shared<const Frame>(std::move(frame)));
+        frame = Frame();
+    }
 
-	    //const uint64_t elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - begin).count();
-	    //const uint64_t fps = UINT64_C(1000) / elapsed_time;
-    } while (true);
-    std::cout << std::endl << "connection closed" << std::endl;
+    shutdown();
+    server.stop();
+    stats::stop_reporter();
+    inference_thread.join();
+    if (collect_thread.joinable()) {
+        collect_thread.join();
+    }
+    encode_thread.join();
+    pools.release();
+    models.release();
 
-    if (socket.is_open()) {
-        socket.close();
+    std::cout << "control commands: " << server.commands() << " command-to-actuation latency: mean="
+                << server.meanLatency() << "us max=" << server.maxLatency() << "us" << std::endl;
+    // over UDP and SHM the video does not go through the clients' connections
+    if (transport == Socket::TCP) {
+        std::cout << "sessions: " << server.sessions() << " time-to-video: mean=" << server.meanTimeToVideo()
+                    << "ms max=" << server.maxTimeToVideo() << "ms" << std::endl;
+    } else {
+        std::cout << "sessions: " << server.sessions() << " time-to-video: not measured, the video is not sent over TCP"
+                    << std::endl;
     }
 
+    std::cout << "captured frames: " << grabber.captured() << std::endl;
+    std::cout << "detected frames: " << inference.detections() + pool_detections << " tracked frames: " << inference.tracked()
+                << " static frames: " << inference.gated() << std::endl;
+    std::cout << "dropped frames: capture=" << grabber.dropped() << " inference=" << detected.dropped()
+                << " encode=" << encoded.dropped() << " clients=" << server.dropped() << " oversized=" << server.oversized()
+                << std::endl;
+    std::cout << std::endl << "server stopped" << std::endl;
+
 	return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,107 @@
+#include <stats.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+
+static Histogram histograms[stats::NUM_STAGES];
+static std::atomic<double> gauges[stats::NUM_GAUGES];
+static std::chrono::steady_clock::time_point last_report = std::chrono::steady_clock::now();
+static std::thread reporter;
+static std::mutex mtx;
+static std::condition_variable cv;
+static bool terminate = false;
+
+const char* stats::name(stats::stage_t stage) {
+    static const char *names[NUM_STAGES] = {
+            "capture", "preprocess", "forward", "postprocess", "track", "draw", "encode", "send"
+    };
+    return stage < NUM_STAGES ? names[stage] : "unknown";
+}
+
+const char* stats::name(stats::gauge_t gauge) {
+    static const char *names[NUM_GAUGES] = {
+            "quality", "width", "height", "latency_ms", "rate_kBps"
+    };
+    return gauge < NUM_GAUGES ? names[gauge] : "unknown";
+}
+
+void stats::set(stats::gauge_t gauge, double value) {
+    gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+double stats::get(stats::gauge_t gauge) {
+    return gauges[gauge].load(std::memory_order_relaxed);
+}
+
+Histogram& stats::histogram(stats::stage_t stage) {
+    return histograms[stage];
+}
+
+void stats::report(std::ostream &os) {
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - last_report).count();
+    last_report = now;
+
+    Histogram::Snapshot snapshots[NUM_STAGES];
+    for (int i = 0; i < NUM_STAGES; ++i) {
+        snapshots[i] = histograms[i].snapshot(true);
+    }
+
+    os << std::fixed << std::setprecision(1)
+       << "[stats] interval=" << elapsed << "s fps=" << (elapsed > 0.0 ? snapshots[SEND].count / elapsed : 0.0)
+       << std::endl;
+    for (int i = 0; i < NUM_STAGES; ++i) {
+        const auto &s = snapshots[i];
+        os << "  " << std::left << std::setw(12) << name((stage_t) i) << std::right
+           << " n=" << s.count
+           << " p50=" << s.percentile(0.5) << "us"
+           << " p99=" << s.percentile(0.99) << "us"
+           << " max=" << s.max << "us" << std::endl;
+    }
+    os << "  stream      ";
+    for (int i = 0; i < NUM_GAUGES; ++i) {
+        os << ' ' << name((gauge_t) i) << '=' << get((gauge_t) i);
+    }
+    os << std::endl;
+}
+
+void stats::start_reporter(unsigned int interval, const std::string &fname) {
+    stop_reporter();
+    if (interval == 0) {
+        return;
+    }
+
+    terminate = false;
+    last_report = std::chrono::steady_clock::now();
+    reporter = std::thread([interval, fname] {
+        std::ofstream file;
+        if (!fname.empty()) {
+            file.open(fname, std::ios::app);
+            if (!file) {
+                std::cout << "cannot open stats file \'" << fname << "\', reporting to stdout" << std::endl;
+            }
+        }
+        std::ostream &os = file.is_open() ? file : std::cout;
+
+        std::unique_lock<std::mutex> lock(mtx);
+        while (!cv.wait_for(lock, std::chrono::seconds(interval), []{ return terminate; })) {
+            report(os);
+        }
+    });
+}
+
+void stats::stop_reporter() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        terminate = true;
+    }
+    cv.notify_all();
+    if (reporter.joinable()) {
+        reporter.join();
+    }
+}
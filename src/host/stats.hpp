@@ -0,0 +1,103 @@
+#ifndef __STATS_HPP
+#define __STATS_HPP
+
+#include <string>
+#include <ostream>
+#include <cstdint>
+#include <Histogram.hpp>
+
+/***
+ * latency instrumentation of the host pipeline, every stage records its
+ * duration in usec into its own lock-free histogram and a reporter thread
+ * periodically dumps p50/p99/max of the past interval
+ * gauges hold the latest value of parameters the pipeline adapts at runtime
+ */
+namespace stats {
+
+    enum stage_t {
+        CAPTURE = 0,    // age of a camera image when the pipeline picks it up
+        PREPROCESS,
+        FORWARD,
+        POSTPROCESS,
+        TRACK,          // box propagation on frames the detector skips
+        DRAW,
+        ENCODE,
+        SEND,
+        NUM_STAGES
+    };
+
+    enum gauge_t {
+        JPEG_QUALITY = 0,
+        STREAM_WIDTH,
+        STREAM_HEIGHT,
+        LINK_LATENCY,   // estimated time until a frame is on the wire in ms
+        LINK_RATE,      // estimated link throughput in kB/s
+        NUM_GAUGES
+    };
+
+    /***
+     * get the name of a stage as it is printed in reports
+     * @param stage
+     * @return
+     */
+    const char* name(stage_t stage);
+
+    /***
+     * get the name of a gauge as it is printed in reports
+     * @param gauge
+     * @return
+     */
+    const char* name(gauge_t gauge);
+
+    /***
+     * set the current value of a gauge
+     * @param gauge
+     * @param value
+     */
+    void set(gauge_t gauge, double value);
+
+    /***
+     * get the current value of a gauge
+     * @param gauge
+     * @return
+     */
+    double get(gauge_t gauge);
+
+    /***
+     * get the histogram of a stage, e.g. to be used with a ScopedTimer
+     * @param stage
+     * @return
+     */
+    Histogram& histogram(stage_t stage);
+
+    /***
+     * record the duration of a stage
+     * @param stage
+     * @param usec
+     */
+    inline void record(stage_t stage, uint64_t usec) {
+        histogram(stage).record(usec);
+    }
+
+    /***
+     * print the statistics collected since the last report and reset them,
+     * the frame rate is derived from the number of frames sent
+     * @param os
+     */
+    void report(std::ostream &os);
+
+    /***
+     * start reporting periodically on a background thread
+     * @param interval in seconds, 0 disables reporting
+     * @param fname file the reports are appended to, stdout if empty
+     */
+    void start_reporter(unsigned int interval, const std::string &fname="");
+
+    /***
+     * stop the reporter thread
+     */
+    void stop_reporter();
+
+}
+
+#endif // __STATS_HPP
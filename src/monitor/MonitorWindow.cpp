@@ -19,6 +19,10 @@ MonitorWindow::~MonitorWindow() {
 }
 
 void MonitorWindow::update_ui() {
+    // the session has ended because the host has gone away
+    if (ui->status->text() == "connected" && !monitor::is_connected()) {
+        disconnect();
+    }
     // only update ui if something has actually changed
     if (modified.load(std::memory_order_consume)) {
         std::lock_guard<std::mutex> lock(this->mtx);
@@ -44,7 +48,7 @@ void MonitorWindow::update_ui() {
     }
 }
 
-static std::set<char> _keySet = { 'q', 'w', 's', 'a', 'd', 'x' };
+static std::set<char> _keySet = { 'q', 'w', 's', 'a', 'd', 'n', 'x' };
 
 bool MonitorWindow::eventFilter(QObject *o, QEvent *e) {
     if (e->type() == QEvent::KeyPress) {
@@ -1,8 +1,33 @@
 #include <MonitorWindow.hpp>
 #include <QApplication>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <config.hpp>
+#include <monitor.hpp>
 
 int main(int argc, char *argv[]) {
     QApplication a(argc, argv);
+
+    // the arguments Qt has not taken are config parameters like those of the host
+    const std::vector<std::string> args(argv, argv + argc);
+    try {
+        if (args.size() > 1 && string::starts_with(args[1], "--config=")) {
+            auto tokens = string::split(args[1], "=");
+            if (tokens.size() >= 2) {
+                config::load(tokens[1]);
+            }
+        }
+        config::parse(args);
+        // the video is received over the transport and with the codec the host sends it with
+        monitor::set_transport(Socket::transport_from_string(
+                config::get_or_default<std::string>("STREAM_TRANSPORT", "TCP")));
+        monitor::set_codec(VideoEncoder::codec_from_string(config::get_or_default<std::string>("STREAM_CODEC", "JPEG")));
+    } catch (std::exception &ex) {
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+
     MonitorWindow w;
     w.show();
 
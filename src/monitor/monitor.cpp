@@ -7,13 +7,20 @@
 #include <opencv2/core.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
+#include <DetectionMessage.hpp>
+#include <VideoReceiver.hpp>
+#include <Framing.hpp>
+#include <Protocol.hpp>
+#include <iostream>
+#include <cstring>
+#include <poll.h>
+#include <memory>
+#include <deque>
+#include <condition_variable>
+#include <string>
 
 using boost::asio::ip::tcp;
 
-#define SEND(sck, ptr, n, err)  if (sck.is_open()) boost::asio::write(sck, boost::asio::const_buffer(ptr, n), err)
-
-#define RECV(sck, ptr, n, err)  if (sck.is_open()) boost::asio::read(sck, boost::asio::buffer(ptr, n), err)
-
 static cv::Mat frame;
 static std::thread t;
 MonitorWindow *monitor::window;
@@ -23,70 +30,215 @@ static boost::asio::io_service io_service;
 static tcp::socket sck(io_service);
 static bool connected = false;
 
+// over UDP the frames are received on their own thread, everything else goes over the socket
+static Socket::transport_t transport = Socket::TCP;
+static VideoEncoder::codec_t codec = VideoEncoder::JPEG;
+static std::unique_ptr<VideoReceiver> video;
+static std::thread video_thread;
+
+// predictions of the last frames by frame id, oldest first
+static std::mutex predictions_mtx;
+static std::condition_variable predictions_cv;
+static std::deque<std::pair<uint64_t, std::vector<Prediction>>> predictions;
+
+// frames over UDP and SHM can be that far behind their predictions and still be matched
+static const size_t PREDICTIONS_KEPT = 64;
+
+// over UDP the tag only carries the low 32 bit of the frame id
+static bool reached(uint64_t id, uint64_t tag) {
+    return (int32_t) ((uint32_t) id - (uint32_t) tag) >= 0;
+}
+
+/***
+ * get the predictions of the frame with the given tag, waits a little for them as
+ * they come over the TCP connection and may fall behind the video
+ * @param tag
+ * @return empty if the host has skipped the predictions of the frame
+ */
+static std::vector<Prediction> predictionsOf(uint64_t tag) {
+    std::unique_lock<std::mutex> lock(predictions_mtx);
+    predictions_cv.wait_for(lock, std::chrono::milliseconds(50), [tag] {
+        return !predictions.empty() && reached(predictions.back().first, tag);
+    });
+    for (auto it = predictions.rbegin(); it != predictions.rend(); ++it) {
+        if ((uint32_t) it->first == (uint32_t) tag) {
+            return it->second;
+        }
+    }
+    return std::vector<Prediction>();
+}
+
+// predictions of the frame that follows on the connection, they are sent ahead of it
+static std::vector<Prediction> newestPredictions() {
+    std::lock_guard<std::mutex> lock(predictions_mtx);
+    return predictions.empty() ? std::vector<Prediction>() : predictions.back().second;
+}
+
+// draw the predictions into a decoded frame and show it
+static void show(cv::Mat &image, const std::vector<Prediction> &overlay, size_t bytes,
+                 std::chrono::system_clock::time_point begin) {
+    using namespace monitor;
+    static cv::Mat scaled;
+    static int i = 0;
+    drawPredictions(image, overlay);
+    window->setFrameSize(image.size[1], image.size[0]);
+    cv::resize(image, scaled, cv::Size(640, 480));
+    cv::cvtColor(scaled, frame, cv::COLOR_RGB2BGR);
+    window->setFrame(frame);
+
+    const std::chrono::system_clock::time_point end = std::chrono::system_clock::now();
+    const uint64_t elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+
+    if (i >= 5 && elapsed_time > 0) {
+        window->setFPS(static_cast<int>(UINT64_C(1000) / elapsed_time));
+        const int data_rate = static_cast<unsigned int>(double(bytes) / double(elapsed_time) * 1000.0);
+        window->setDataRate(data_rate);
+        i = 0;
+    } else {
+        i++;
+    }
+}
+
+// video thread function if the frames are not sent over the socket
+static void receiver() {
+    using namespace monitor;
+    cv::Mat image;
+    while (!terminate) {
+        const std::chrono::system_clock::time_point begin = std::chrono::system_clock::now();
+        // gives up after a while without frames, so terminate is checked
+        if (video->read(image)) {
+            // the host tags the frames with their id, the predictions are matched by it
+            show(image, predictionsOf(video->frameTag()), video->frameSize(), begin);
+        } else if (!video->isConnected()) {
+            window->setMessage("video stream closed");
+            break;
+        }
+    }
+}
+
 // monitor thread function
 static void transceiver() {
     using namespace monitor;
     boost::system::error_code err;
-    uint32_t n = 0;
-    cv::Mat tmp, scaled;
-    std::vector<unsigned char> buffer(640 * 480 * 3);
+    cv::Mat tmp;
+    // created with the first VP8 frame, it keeps the state of the stream
+    std::unique_ptr<VideoDecoder> decoder;
+    protocol::Writer writer;
+    protocol::Header header;
+    std::vector<unsigned char> payload;
+    uint64_t frame_id = 0;
+    std::vector<Prediction> received;
+    auto last_ping = std::chrono::steady_clock::now();
     control = 0x00;
-    int i = 0;
 
     while (!terminate) {
         // if user has entered a control command
         // send it to host
         const char c = control.exchange(0x00);
         if (c != 0x00) {
-            SEND(sck, &c, 1, err);
+            writer.add(protocol::COMMAND, &c, 1);
+        }
+        // the round trip time is measured with pings on the control channel
+        if (std::chrono::steady_clock::now() - last_ping >= std::chrono::seconds(1)) {
+            writer.add(protocol::PING, nullptr, 0);
+            last_ping = std::chrono::steady_clock::now();
+        }
+        if (writer.size() > 0 && sck.is_open()) {
+            writer.write(sck, err);
             if (err) {
                 window->setMessage(err.message());
             }
         }
 
-        if (sck.available()) {
+        // readable once a message has arrived or the host has closed the connection
+        pollfd pfd = { sck.native_handle(), POLLIN, 0 };
+        if (::poll(&pfd, 1, 0) > 0) {
             const std::chrono::system_clock::time_point begin = std::chrono::system_clock::now();
-            // read size of compressed image from frame
-            RECV(sck, &n, sizeof(n), err);
-            if (err) {
-                window->setMessage(err.message());
-            }
-            n = ntohl(n);
-
-            // read image from getNetwork
-            buffer.reserve(n);
-            RECV(sck, buffer.data(), n, err);
-            if (err) {
+            if (!protocol::read(sck, header, payload, err)) {
+                // the host is gone or the stream cannot be resynchronized, the session ends
                 window->setMessage(err.message());
+                terminate = true;
+                boost::system::error_code error;
+                sck.close(error);
+                break;
             }
 
-            cv::imdecode(buffer, cv::IMREAD_COLOR, &tmp);
-            window->setFrameSize(tmp.size[1], tmp.size[0]);
-            cv::resize(tmp, scaled, cv::Size(640, 480));
-            cv::cvtColor(scaled, frame, cv::COLOR_RGB2BGR);
-            window->setFrame(frame);
-
-            const std::chrono::system_clock::time_point end = std::chrono::system_clock::now();
-            const uint64_t elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
-
-            if (i >= 5) {
-                window->setFPS(static_cast<int>(UINT64_C(1000) / elapsed_time));
-                const int data_rate = static_cast<unsigned int>(double(n) / double(elapsed_time) * 1000.0);
-                window->setDataRate(data_rate);
-                window->setPing((n * UINT32_C(1000)) / data_rate);
-                i = 0;
-            } else {
-                i++;
+            switch (header.type) {
+                case protocol::DETECTION_LIST: {
+                    // predictions are sent ahead of their frame, overlays are drawn here instead of on the host
+                    std::lock_guard<std::mutex> lock(predictions_mtx);
+                    if (detection_message::deserialize(payload.data(), payload.size(), frame_id, received)) {
+                        predictions.emplace_back(frame_id, std::move(received));
+                        if (predictions.size() > PREDICTIONS_KEPT) {
+                            predictions.pop_front();
+                        }
+                    } else {
+                        // nothing is drawn rather than predictions of another frame
+                        predictions.clear();
+                    }
+                    predictions_cv.notify_all();
+                    break;
+                }
+                case protocol::PONG:
+                    window->setPing((int) ((protocol::now() - header.timestamp) / 1000));
+                    break;
+                case protocol::STATS:
+                    if (payload.size() == sizeof(protocol::Telemetry)) {
+                        protocol::Telemetry telemetry;
+                        std::memcpy(&telemetry, payload.data(), sizeof(telemetry));
+                        protocol::swap_batch(&telemetry, 1);
+                        window->setMessage("quality=" + std::to_string((int) telemetry.jpeg_quality)
+                                           + " dropped=" + std::to_string(telemetry.dropped));
+                    }
+                    break;
+                case protocol::JPEG_FRAME:
+                    cv::imdecode(payload, cv::IMREAD_COLOR, &tmp);
+                    if (!tmp.empty()) {
+                        show(tmp, newestPredictions(), payload.size(), begin);
+                    }
+                    break;
+                case protocol::VP8_FRAME:
+                    try {
+                        if (!decoder) {
+                            decoder = VideoDecoder::create(VideoEncoder::VP8);
+                        }
+                        if (decoder->decode(payload, tmp)) {
+                            show(tmp, newestPredictions(), payload.size(), begin);
+                        }
+                    } catch (std::exception &ex) {
+                        // built without libvpx
+                        window->setMessage(ex.what());
+                    }
+                    break;
+                default:
+                    // unknown types of newer hosts are skipped
+                    break;
             }
         }
     }
 }
 
+void monitor::set_transport(Socket::transport_t t) {
+    transport = t;
+}
+
+void monitor::set_codec(VideoEncoder::codec_t c) {
+    codec = c;
+}
+
 bool monitor::connect(const std::string &address, int port) {
     if (!connected) {
         try {
             sck.connect(tcp::endpoint(boost::asio::ip::address::from_string(address), port));
+            // control commands are single bytes, they must not wait for an ACK
+            framing::set_policy(sck, framing::NODELAY);
+            // the host sends the video to the port of the same number or its shared memory segment
+            if (transport != Socket::TCP) {
+                video.reset(new VideoReceiver(address, port, transport, codec));
+            }
         } catch (std::exception &e) {
+            boost::system::error_code error;
+            sck.close(error);
             window->setMessage(e.what());
             return false;
         }
@@ -98,24 +250,45 @@ bool monitor::connect(const std::string &address, int port) {
 }
 
 void monitor::start_transceiver() {
+    {
+        // the ids of the last session mean nothing to the new one
+        std::lock_guard<std::mutex> lock(predictions_mtx);
+        predictions.clear();
+    }
     terminate = false;
     control = 0x00;
     t = std::thread(transceiver);
+    if (video) {
+        video_thread = std::thread(receiver);
+    }
 }
 
 void monitor::send_control(char ctl) {
     control = ctl;
 }
 
+bool monitor::is_connected() {
+    return connected && !terminate;
+}
+
 void monitor::disconnect() {
     if (connected) {
-        if (sck.is_open()) {
+        // the transceiver sends the x unless it has ended the session itself
+        if (!terminate) {
             send_control('x');
             std::this_thread::sleep_for(std::chrono::milliseconds(150));
-            sck.close();
         }
         terminate = true;
         t.join();
+        boost::system::error_code error;
+        sck.close(error);
+        if (video_thread.joinable()) {
+            video_thread.join();
+        }
+        if (transport == Socket::UDP) {
+            std::cout << "video " << video->getStats() << std::endl;
+        }
+        video.reset();
     }
     connected = false;
 }
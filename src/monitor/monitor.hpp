@@ -3,13 +3,31 @@
 
 #include <string>
 #include <MonitorWindow.hpp>
+#include <Socket.hpp>
+#include <VideoCodec.hpp>
 
 namespace monitor {
 
     extern MonitorWindow *window;
 
+    /***
+     * set the transport the host sends the video with, must be called before connecting
+     * @param transport
+     */
+    void set_transport(Socket::transport_t transport);
+
+    /***
+     * set the codec of the video sent over UDP, over TCP every frame carries its codec
+     * @param codec
+     */
+    void set_codec(VideoEncoder::codec_t codec);
+
     bool connect(const std::string &address, int port);
 
+    /***
+     * check if the session is running, it ends on its own when the connection to the host is lost
+     * @return
+     */
     bool is_connected();
 
     void start_transceiver();
@@ -0,0 +1,54 @@
+#ifndef __FRAGMENT_HPP
+#define __FRAGMENT_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/***
+ * layout of the datagrams of the UDP video transport
+ * a frame is split into fragments that fit into a single datagram, every
+ * fragment starts with a header of 32 bit fields in network byte order
+ *      u32 frame id
+ *      u32 index of the fragment
+ *      u32 number of fragments of the frame
+ *      u32 size of the whole frame in bytes
+ *      u32 send time of the fragment in usec, wraps around
+ *      u32 tag the application has given the frame, e.g. the host's frame number
+ * followed by the fragment's share of the frame, all fragments but the
+ * last one carry the same number of bytes
+ */
+namespace fragment {
+
+    struct Header {
+
+        uint32_t frame_id;
+
+        uint32_t index;
+
+        uint32_t count;
+
+        uint32_t frame_size;
+
+        uint32_t timestamp;
+
+        uint32_t tag;
+
+    };
+
+    // size of the header in bytes
+    constexpr size_t HEADER_SIZE = 24;
+
+    static_assert(sizeof(Header) == HEADER_SIZE, "fragment header must not be padded");
+
+    // default size of a datagram, leaves room for IP and UDP headers below a 1500 byte MTU
+    constexpr size_t DEFAULT_DATAGRAM_SIZE = 1400;
+
+    // largest frame that can be sent, a frame of more fragments is a corrupt header
+    constexpr uint32_t MAX_FRAME_SIZE = 16 * 1024 * 1024;
+
+    // datagram a receiver sends to register itself with the sender
+    constexpr uint32_t HELLO = 0x48454c4f;
+
+}
+
+#endif // __FRAGMENT_HPP
@@ -0,0 +1,99 @@
+#include <Framing.hpp>
+#include <common.hpp>
+#include <stdexcept>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+framing::policy_t framing::policy_from_string(const std::string &str) {
+    if (string::iequals(str, "NAGLE")) {
+        return NAGLE;
+    } else if (string::iequals(str, "NODELAY")) {
+        return NODELAY;
+    } else if (string::iequals(str, "CORK")) {
+        return CORK;
+    } else {
+        throw std::invalid_argument("unknown TCP policy '" + str + "'");
+    }
+}
+
+void framing::set_policy(boost::asio::ip::tcp::socket &socket, framing::policy_t policy) {
+    boost::system::error_code error;
+    socket.set_option(boost::asio::ip::tcp::no_delay(policy == NODELAY), error);
+    if (error) {
+        throw std::runtime_error(error.message());
+    }
+}
+
+static void cork(boost::asio::ip::tcp::socket &socket, bool enable) {
+    const int value = enable ? 1 : 0;
+    ::setsockopt(socket.native_handle(), IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+}
+
+void framing::Message::clear() {
+    _headers.clear();
+    _parts.clear();
+    _buffers.clear();
+    _dirty = false;
+    _size = 0;
+}
+
+void framing::Message::add(const void *data, size_t size) {
+    if (size > UINT32_MAX) {
+        throw std::invalid_argument("message part too large");
+    }
+    _headers.push_back(htonl((uint32_t) size));
+    _parts.emplace_back(data, size);
+    _size += sizeof(uint32_t) + size;
+    _dirty = true;
+}
+
+const std::vector<boost::asio::const_buffer>& framing::Message::buffers() const {
+    // the headers may have been moved while parts were added
+    if (_dirty) {
+        _buffers.clear();
+        for (size_t i = 0; i < _parts.size(); ++i) {
+            _buffers.emplace_back(&_headers[i], sizeof(uint32_t));
+            if (boost::asio::buffer_size(_parts[i]) > 0) {
+                _buffers.push_back(_parts[i]);
+            }
+        }
+        _dirty = false;
+    }
+    return _buffers;
+}
+
+size_t framing::Message::size() const {
+    return _size;
+}
+
+size_t framing::write(boost::asio::ip::tcp::socket &socket, const framing::Message &message, framing::policy_t policy,
+                      boost::system::error_code &error) {
+    return write(socket, message.buffers(), policy, error);
+}
+
+size_t framing::write(boost::asio::ip::tcp::socket &socket, const std::vector<boost::asio::const_buffer> &buffers,
+                      framing::policy_t policy, boost::system::error_code &error) {
+    // a large message can take several syscalls, corking keeps the kernel from sending its tail as a runt segment
+    if (policy == CORK) {
+        cork(socket, true);
+    }
+    const size_t n = boost::asio::write(socket, buffers, error);
+    if (policy == CORK) {
+        // uncorking flushes what is left
+        cork(socket, false);
+    }
+    return n;
+}
+
+void framing::async_write(boost::asio::ip::tcp::socket &socket, const std::vector<boost::asio::const_buffer> &buffers,
+                          framing::policy_t policy, const framing::handler_t &handler) {
+    if (policy == CORK) {
+        cork(socket, true);
+    }
+    boost::asio::async_write(socket, buffers, [&socket, policy, handler](const boost::system::error_code &error, size_t n) {
+        if (policy == CORK) {
+            cork(socket, false);
+        }
+        handler(error, n);
+    });
+}
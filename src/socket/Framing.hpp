@@ -0,0 +1,130 @@
+#ifndef __FRAMING_HPP
+#define __FRAMING_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <boost/asio.hpp>
+
+/***
+ * length prefixed framing of messages sent over a TCP stream
+ * every part of a message is preceded by its size as big endian u32,
+ * the headers and payloads of a whole message are handed to the kernel
+ * as one buffer sequence, so it goes out with a single gather write
+ * instead of a write per header and payload
+ */
+namespace framing {
+
+    enum policy_t {
+        NAGLE = 0,  // default behaviour of the socket, small writes are coalesced
+        NODELAY,    // TCP_NODELAY, segments are sent right away
+        CORK        // TCP_CORK while a message is written, only full segments leave until it is complete
+    };
+
+    /***
+     * get the policy from a string, "NAGLE", "NODELAY" or "CORK"
+     * @param str
+     * @return
+     */
+    policy_t policy_from_string(const std::string &str);
+
+    /***
+     * configure the socket for the policy, must be called once after connecting
+     * @param socket
+     * @param policy
+     */
+    void set_policy(boost::asio::ip::tcp::socket &socket, policy_t policy);
+
+    /***
+     * message made up of length prefixed parts, the parts are not copied
+     * and must stay valid until the message has been written
+     */
+    class Message {
+    public:
+
+        Message() = default;
+
+        /***
+         * remove all parts, the memory is kept for the next message
+         */
+        void clear();
+
+        /***
+         * append a part to the message
+         * @param data
+         * @param size
+         */
+        void add(const void *data, size_t size);
+
+        template <typename T>
+        void add(const std::vector<T> &part) {
+            add(part.data(), part.size() * sizeof(T));
+        }
+
+        /***
+         * get the buffer sequence of headers and payloads
+         * @return
+         */
+        const std::vector<boost::asio::const_buffer>& buffers() const;
+
+        /***
+         * get the number of bytes of the message including the headers
+         * @return
+         */
+        size_t size() const;
+
+    private:
+
+        // headers are stored separately, the buffer sequence is only built once all parts are known
+        std::vector<uint32_t> _headers;
+
+        std::vector<boost::asio::const_buffer> _parts;
+
+        mutable std::vector<boost::asio::const_buffer> _buffers;
+
+        mutable bool _dirty = false;
+
+        size_t _size = 0;
+
+    };
+
+    /***
+     * write a message with a single gather write
+     * @param socket
+     * @param message
+     * @param policy the policy the socket has been configured with
+     * @param error
+     * @return number of bytes written
+     */
+    size_t write(boost::asio::ip::tcp::socket &socket, const Message &message, policy_t policy,
+                 boost::system::error_code &error);
+
+    /***
+     * write a buffer sequence with a single gather write
+     * @param socket
+     * @param buffers
+     * @param policy the policy the socket has been configured with
+     * @param error
+     * @return number of bytes written
+     */
+    size_t write(boost::asio::ip::tcp::socket &socket, const std::vector<boost::asio::const_buffer> &buffers,
+                 policy_t policy, boost::system::error_code &error);
+
+    // called once an asynchronous write has completed with the error and the number of bytes written
+    typedef std::function<void (const boost::system::error_code&, size_t)>  handler_t;
+
+    /***
+     * start writing a buffer sequence without blocking, the handler is called from
+     * the thread running the socket's io_service once everything has been written
+     * @param socket
+     * @param buffers the memory they refer to must stay valid until the handler is called
+     * @param policy the policy the socket has been configured with
+     * @param handler
+     */
+    void async_write(boost::asio::ip::tcp::socket &socket, const std::vector<boost::asio::const_buffer> &buffers,
+                     policy_t policy, const handler_t &handler);
+
+}
+
+#endif // __FRAMING_HPP
@@ -0,0 +1,129 @@
+#include <Protocol.hpp>
+#include <chrono>
+#include <stdexcept>
+
+protocol::channel_t protocol::channel_of(protocol::type_t type) {
+    switch (type) {
+        case COMMAND:
+        case PING:
+        case PONG:
+            return CONTROL;
+        case JPEG_FRAME:
+        case VP8_FRAME:
+            return VIDEO;
+        case DETECTION_LIST:
+            return DETECTIONS;
+        case STATS:
+            return TELEMETRY;
+        default:
+            throw std::invalid_argument("unknown message type");
+    }
+}
+
+uint64_t protocol::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void protocol::swap(protocol::Header &header) {
+    header.type = inet_bswap(header.type);
+    header.seq = inet_bswap(header.seq);
+    header.timestamp = inet_bswap(header.timestamp);
+    header.length = inet_bswap(header.length);
+    header.reserved = inet_bswap(header.reserved);
+}
+
+bool protocol::valid(const protocol::Header &header) {
+    return header.version == VERSION && header.channel < NUM_CHANNELS && header.length <= MAX_PAYLOAD;
+}
+
+protocol::Writer::Writer(framing::policy_t policy) :
+        _policy(policy) {}
+
+void protocol::Writer::setPolicy(framing::policy_t policy) {
+    _policy = policy;
+}
+
+void protocol::Writer::add(protocol::type_t type, const void *payload, size_t size, uint64_t timestamp) {
+    if (size > MAX_PAYLOAD) {
+        throw std::invalid_argument("payload too large");
+    }
+    Header header;
+    header.channel = (uint8_t) channel_of(type);
+    header.type = (uint16_t) type;
+    header.seq = _seq[header.channel]++;
+    header.timestamp = timestamp != 0 ? timestamp : now();
+    header.length = (uint32_t) size;
+    swap(header);
+    _headers.push_back(header);
+    _payloads.emplace_back(payload, size);
+    _size += HEADER_SIZE + size;
+}
+
+void protocol::Writer::reply(protocol::type_t type, uint32_t seq, uint64_t timestamp) {
+    Header header;
+    header.channel = (uint8_t) channel_of(type);
+    header.type = (uint16_t) type;
+    header.seq = seq;
+    header.timestamp = timestamp;
+    swap(header);
+    _headers.push_back(header);
+    _payloads.emplace_back(nullptr, 0);
+    _size += HEADER_SIZE;
+}
+
+void protocol::Writer::clear() {
+    _headers.clear();
+    _payloads.clear();
+    _buffers.clear();
+    _size = 0;
+}
+
+size_t protocol::Writer::size() const {
+    return _size;
+}
+
+const std::vector<boost::asio::const_buffer>& protocol::Writer::buffers() {
+    _buffers.clear();
+    for (size_t i = 0; i < _headers.size(); ++i) {
+        _buffers.emplace_back(&_headers[i], HEADER_SIZE);
+        if (boost::asio::buffer_size(_payloads[i]) > 0) {
+            _buffers.push_back(_payloads[i]);
+        }
+    }
+    return _buffers;
+}
+
+size_t protocol::Writer::write(boost::asio::ip::tcp::socket &socket, boost::system::error_code &error) {
+    // the headers do not move anymore, all messages go out with one gather write
+    const size_t n = framing::write(socket, buffers(), _policy, error);
+    clear();
+    return n;
+}
+
+void protocol::Writer::async_write(boost::asio::ip::tcp::socket &socket, const framing::handler_t &handler) {
+    // headers and buffers are in use until the write has completed
+    framing::async_write(socket, buffers(), _policy, [this, handler](const boost::system::error_code &error, size_t n) {
+        clear();
+        handler(error, n);
+    });
+}
+
+bool protocol::read(boost::asio::ip::tcp::socket &socket, protocol::Header &header, std::vector<unsigned char> &payload,
+                    boost::system::error_code &error) {
+    boost::asio::read(socket, boost::asio::buffer(&header, HEADER_SIZE), error);
+    if (error) {
+        return false;
+    }
+    swap(header);
+    if (!valid(header)) {
+        // the stream cannot be resynchronized
+        error = boost::asio::error::invalid_argument;
+        return false;
+    }
+    payload.resize(header.length);
+    if (header.length > 0) {
+        boost::asio::read(socket, boost::asio::buffer(payload), error);
+    }
+    return !error;
+}
@@ -0,0 +1,249 @@
+#ifndef __PROTOCOL_HPP
+#define __PROTOCOL_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <boost/asio.hpp>
+#include <common.hpp>
+#include <Framing.hpp>
+
+/***
+ * Typed and versioned messages exchanged between host and monitor.
+ * Every message starts with a fixed header in network byte order
+ *      u8  version
+ *      u8  channel
+ *      u16 type
+ *      u32 sequence number, counted per channel
+ *      u64 timestamp in usec since epoch
+ *      u32 payload length
+ *      u32 reserved
+ * followed by the payload. Messages of different channels are multiplexed
+ * over one connection, a receiver can skip types it does not know as the
+ * length of every payload is known up front.
+ * Payloads are POD structs of 32 bit fields that are byte swapped as a
+ * whole and sent without further copies.
+ */
+namespace protocol {
+
+    constexpr uint8_t VERSION = 1;
+
+    // size of the header in bytes
+    constexpr size_t HEADER_SIZE = 24;
+
+    // payloads larger than this are rejected, a corrupt header must not allocate gigabytes
+    constexpr uint32_t MAX_PAYLOAD = 64 * 1024 * 1024;
+
+    enum channel_t {
+        CONTROL = 0,
+        VIDEO,
+        DETECTIONS,
+        TELEMETRY,
+        NUM_CHANNELS
+    };
+
+    enum type_t {
+        COMMAND = 0,    // control: u8 key pressed on the monitor
+        PING,           // control: no payload
+        PONG,           // control: no payload, echoes sequence number and timestamp of the ping
+        JPEG_FRAME,     // video: JPEG image, timestamp is the capture time
+        DETECTION_LIST, // detections: detection message of the following frame
+        STATS,          // telemetry: Telemetry
+        VP8_FRAME,      // video: VP8 frame, timestamp is the capture time
+        NUM_TYPES
+    };
+
+    struct Header {
+
+        uint8_t version = VERSION;
+
+        uint8_t channel = 0;
+
+        uint16_t type = 0;
+
+        uint32_t seq = 0;
+
+        uint64_t timestamp = 0;
+
+        uint32_t length = 0;
+
+        uint32_t reserved = 0;
+
+    };
+
+    static_assert(sizeof(Header) == HEADER_SIZE, "protocol header must not be padded");
+
+    // state of the host, sent periodically
+    struct Telemetry {
+
+        float jpeg_quality = 0.0f;
+
+        uint32_t width = 0;
+
+        uint32_t height = 0;
+
+        float link_latency = 0.0f;  // ms
+
+        float link_rate = 0.0f;     // kB/s
+
+        uint32_t sent = 0;          // frames sent to this client
+
+        uint32_t dropped = 0;       // frames dropped for this client
+
+    };
+
+    /***
+     * get the channel a message type belongs to
+     * @param type
+     * @return
+     */
+    channel_t channel_of(type_t type);
+
+    /***
+     * get the current time in usec since epoch as used in headers
+     * @return
+     */
+    uint64_t now();
+
+    /***
+     * convert header between host and network byte order, in place
+     * @param header
+     */
+    void swap(Header &header);
+
+    /***
+     * swap the byte order of all 32 bit words of a memory region in place
+     * @param data
+     * @param words
+     */
+    inline void swap_words(void *data, size_t words) {
+        auto ptr = static_cast<unsigned char*>(data);
+        for (size_t i = 0; i < words; ++i, ptr += sizeof(uint32_t)) {
+            uint32_t word;
+            std::memcpy(&word, ptr, sizeof(word));
+            word = inet_bswap(word);
+            std::memcpy(ptr, &word, sizeof(word));
+        }
+    }
+
+    /***
+     * convert an array of POD records between host and network byte order, in place
+     * all fields of T must be 32 bit wide
+     * @param records
+     * @param n
+     */
+    template <typename T>
+    void swap_batch(T *records, size_t n) {
+        static_assert(std::is_trivially_copyable<T>::value && sizeof(T) % sizeof(uint32_t) == 0,
+                      "records must be PODs of 32 bit fields");
+        swap_words(records, n * sizeof(T) / sizeof(uint32_t));
+    }
+
+    /***
+     * collects messages and sends them with a single gather write,
+     * payloads are not copied and must stay valid until write() returns
+     * sequence numbers are counted per channel for the lifetime of the writer
+     */
+    class Writer {
+    public:
+
+        explicit Writer(framing::policy_t policy=framing::NODELAY);
+
+        void setPolicy(framing::policy_t policy);
+
+        /***
+         * append a message
+         * @param type
+         * @param payload
+         * @param size
+         * @param timestamp 0 for now()
+         */
+        void add(type_t type, const void *payload, size_t size, uint64_t timestamp=0);
+
+        template <typename T>
+        void add(type_t type, const std::vector<T> &payload, uint64_t timestamp=0) {
+            add(type, payload.data(), payload.size() * sizeof(T), timestamp);
+        }
+
+        /***
+         * append a message without payload that echoes sequence number and timestamp
+         * of a received message, e.g. a PONG
+         * @param type
+         * @param seq
+         * @param timestamp
+         */
+        void reply(type_t type, uint32_t seq, uint64_t timestamp);
+
+        /***
+         * remove all messages that have not been written
+         */
+        void clear();
+
+        /***
+         * get the number of bytes of all messages including their headers
+         * @return
+         */
+        size_t size() const;
+
+        /***
+         * send all messages and remove them
+         * @param socket
+         * @param error
+         * @return number of bytes written
+         */
+        size_t write(boost::asio::ip::tcp::socket &socket, boost::system::error_code &error);
+
+        /***
+         * start sending all messages without blocking, they are removed before the handler
+         * is called and no message may be added until then
+         * @param socket
+         * @param handler called from the thread running the socket's io_service
+         */
+        void async_write(boost::asio::ip::tcp::socket &socket, const framing::handler_t &handler);
+
+    private:
+
+        /***
+         * interleave headers and payloads, the headers must not move anymore
+         * @return
+         */
+        const std::vector<boost::asio::const_buffer>& buffers();
+
+        framing::policy_t _policy;
+
+        uint32_t _seq[NUM_CHANNELS] = {};
+
+        // headers in network byte order and payloads, interleaved once all messages are known
+        std::vector<Header> _headers;
+
+        std::vector<boost::asio::const_buffer> _payloads;
+
+        std::vector<boost::asio::const_buffer> _buffers;
+
+        size_t _size = 0;
+
+    };
+
+    /***
+     * read a whole message, blocks until it has arrived
+     * @param socket
+     * @param header set to the header in host byte order
+     * @param payload overwritten with the payload
+     * @param error set if reading failed or the message is not valid
+     * @return false on error
+     */
+    bool read(boost::asio::ip::tcp::socket &socket, Header &header, std::vector<unsigned char> &payload,
+              boost::system::error_code &error);
+
+    /***
+     * check the header of a received message, in host byte order
+     * @param header
+     * @return false if the version does not match or the payload is too large
+     */
+    bool valid(const Header &header);
+
+}
+
+#endif // __PROTOCOL_HPP
@@ -0,0 +1,56 @@
+#include <SharedRing.hpp>
+#include <ctime>
+#include <climits>
+#include <chrono>
+#include <thread>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static size_t align(size_t size) {
+    return (size + shared_ring::ALIGNMENT - 1) / shared_ring::ALIGNMENT * shared_ring::ALIGNMENT;
+}
+
+std::string shared_ring::name(int port) {
+    return "/robotcar-" + std::to_string(port);
+}
+
+size_t shared_ring::segment_size(size_t capacity) {
+    return align(sizeof(Header)) + SLOTS * (align(sizeof(Slot)) + align(capacity));
+}
+
+shared_ring::Slot* shared_ring::slot(void *segment, uint32_t index) {
+    const auto header = static_cast<Header*>(segment);
+    const size_t offset = align(sizeof(Header)) + index * (align(sizeof(Slot)) + align(header->capacity));
+    return reinterpret_cast<Slot*>(static_cast<unsigned char*>(segment) + offset);
+}
+
+unsigned char* shared_ring::data(Slot *slot) {
+    return reinterpret_cast<unsigned char*>(slot) + align(sizeof(Slot));
+}
+
+void shared_ring::wait(std::atomic<uint32_t> &word, uint32_t value, double timeout) {
+#ifdef __linux__
+    // not FUTEX_PRIVATE_FLAG, the word is shared between processes
+    timespec ts = {};
+    if (timeout >= 0.0) {
+        const auto usec = (long long) (timeout * 1000.0);
+        ts.tv_sec = (time_t) (usec / 1000000);
+        ts.tv_nsec = (long) (usec % 1000000) * 1000;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value,
+            timeout >= 0.0 ? &ts : nullptr, nullptr, 0);
+#else
+    if (word.load() == value) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+#endif
+}
+
+void shared_ring::wake(std::atomic<uint32_t> &word) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
@@ -0,0 +1,171 @@
+#ifndef __SHAREDRING_HPP
+#define __SHAREDRING_HPP
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/***
+ * layout of the POSIX shared memory segment of the local video transport
+ * the segment starts with a header followed by three slots that each hold
+ * a raw frame, the slots are passed between the sender and a single receiver
+ * like a triple buffer:
+ *      the sender owns one slot it writes the next frame into
+ *      the receiver owns one slot with the frame it is working on
+ *      the third slot holds the newest frame that has been published
+ * Publishing exchanges the sender's slot with the third one and reading
+ * exchanges the receiver's slot with it, the FRESH bit of the exchanged
+ * index tells the receiver if a new frame is waiting. Neither side ever
+ * waits for the other, a receiver that falls behind gets the newest frame
+ * and the ones in between are counted as dropped by their sequence number.
+ * The receiver waits for the next frame on a futex, the word is the number
+ * of frames that have been published.
+ * Header and slots are aligned to cache lines, the data of a slot is
+ * stored row after row without padding.
+ */
+namespace shared_ring {
+
+    struct Header {
+
+        // written last by the sender once the segment has been set up
+        std::atomic<uint32_t> magic;
+
+        uint32_t version;
+
+        // size of the data of a slot in bytes
+        uint64_t capacity;
+
+        // index of the slot with the newest frame, or'ed with FRESH if it has not been read
+        std::atomic<uint32_t> state;
+
+        // futex word, number of published frames, wraps around
+        std::atomic<uint32_t> published;
+
+        // futex word, 1 while a receiver is attached
+        std::atomic<uint32_t> reader;
+
+        // slot owned by the receiver, a receiver that attaches takes over the slot of the last one
+        uint32_t receiver_slot;
+
+        // set by the sender when it stops streaming
+        std::atomic<uint32_t> closed;
+
+    };
+
+    struct Slot {
+
+        // sequence number of the frame, starting at 1
+        uint64_t seq;
+
+        // size and OpenCV type of the frame
+        int32_t rows;
+
+        int32_t cols;
+
+        int32_t type;
+
+        uint32_t reserved;
+
+        // bytes per row
+        uint64_t step;
+
+        // size of the frame in bytes
+        uint64_t size;
+
+        // tag the sender has given the frame, e.g. the host's frame number
+        uint64_t tag;
+
+    };
+
+    /***
+     * frame as seen by the receiver, the data lives in the segment
+     */
+    struct Frame {
+
+        unsigned char *data = nullptr;
+
+        int rows = 0;
+
+        int cols = 0;
+
+        int type = 0;
+
+        size_t step = 0;
+
+        uint64_t seq = 0;
+
+        uint64_t tag = 0;
+
+    };
+
+    static_assert(ATOMIC_INT_LOCK_FREE == 2, "shared atomics must be lock free");
+
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be 32 bit");
+
+    constexpr uint32_t MAGIC = 0x52435352;
+
+    constexpr uint32_t VERSION = 3;
+
+    constexpr uint32_t SLOTS = 3;
+
+    constexpr uint32_t FRESH = 0x4;
+
+    // slots owned by sender and receiver when the segment is created, the third one is in the state
+    constexpr uint32_t SENDER_SLOT = 0;
+
+    constexpr uint32_t STATE_SLOT = 1;
+
+    constexpr uint32_t RECEIVER_SLOT = 2;
+
+    constexpr size_t ALIGNMENT = 64;
+
+    // default capacity of a slot, a 1080p BGR frame
+    constexpr size_t DEFAULT_CAPACITY = 1920 * 1080 * 3;
+
+    /***
+     * get the name of the segment of a port, like the port of a socket it tells streams apart
+     * @param port
+     * @return
+     */
+    std::string name(int port);
+
+    /***
+     * get the size of a segment
+     * @param capacity of a slot
+     * @return
+     */
+    size_t segment_size(size_t capacity);
+
+    /***
+     * get a slot of a mapped segment
+     * @param segment
+     * @param index
+     * @return
+     */
+    Slot* slot(void *segment, uint32_t index);
+
+    /***
+     * get the data of a slot
+     * @param slot
+     * @return
+     */
+    unsigned char* data(Slot *slot);
+
+    /***
+     * wait until a futex word is changed and woken up
+     * @param word
+     * @param value the word is expected to have, returns at once otherwise
+     * @param timeout in msec, negative waits forever
+     */
+    void wait(std::atomic<uint32_t> &word, uint32_t value, double timeout);
+
+    /***
+     * wake up all processes waiting on a futex word
+     * @param word
+     */
+    void wake(std::atomic<uint32_t> &word);
+
+}
+
+#endif // __SHAREDRING_HPP
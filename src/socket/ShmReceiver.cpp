@@ -0,0 +1,119 @@
+#include <ShmReceiver.hpp>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+ShmReceiver::~ShmReceiver() {
+    close();
+}
+
+void ShmReceiver::connect(const std::string &name) {
+    close();
+    const int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error(name + ": " + std::strerror(errno));
+    }
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(shared_ring::Header)) {
+        ::close(fd);
+        throw std::runtime_error(name + ": shared memory segment not ready");
+    }
+    const auto size = (size_t) st.st_size;
+    void *segment = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (segment == MAP_FAILED) {
+        throw std::runtime_error(name + ": " + std::strerror(errno));
+    }
+
+    const auto header = static_cast<shared_ring::Header*>(segment);
+    if (header->magic.load(std::memory_order_acquire) != shared_ring::MAGIC
+        || header->version != shared_ring::VERSION
+        || shared_ring::segment_size(header->capacity) > size) {
+        munmap(segment, size);
+        throw std::runtime_error(name + ": not a video stream segment");
+    }
+    uint32_t expected = 0;
+    if (!header->reader.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+        munmap(segment, size);
+        throw std::runtime_error(name + ": stream already has a receiver");
+    }
+    shared_ring::wake(header->reader);
+
+    _segment = segment;
+    _size = size;
+    _header = header;
+    // the slots have been passed around, the one a former receiver held is neither the sender's nor the newest
+    _slot = header->receiver_slot;
+    _last = 0;
+    _frames = 0;
+    _dropped = 0;
+}
+
+bool ShmReceiver::read(shared_ring::Frame &frame, double timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds((int64_t) (timeout * 1000.0));
+    while (_header != nullptr) {
+        // a frame published before the sender has closed the segment is still read
+        const bool closed = _header->closed.load(std::memory_order_acquire) != 0;
+        // read the futex word first, a frame published after the check below changes it
+        const uint32_t published = _header->published.load(std::memory_order_acquire);
+        if (_header->state.load(std::memory_order_acquire) & shared_ring::FRESH) {
+            // hand the slot of the last frame back and take the newest one
+            const uint32_t state = _header->state.exchange(_slot, std::memory_order_acq_rel);
+            _slot = state & ~shared_ring::FRESH;
+
+            shared_ring::Slot *slot = shared_ring::slot(_segment, _slot);
+            frame.data = shared_ring::data(slot);
+            frame.rows = slot->rows;
+            frame.cols = slot->cols;
+            frame.type = slot->type;
+            frame.step = (size_t) slot->step;
+            frame.seq = slot->seq;
+            frame.tag = slot->tag;
+            if (_last != 0 && slot->seq > _last + 1) {
+                _dropped += slot->seq - _last - 1;
+            }
+            _last = slot->seq;
+            _frames += 1;
+            return true;
+        }
+        if (closed) {
+            break;
+        }
+
+        const auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            break;
+        }
+        shared_ring::wait(_header->published, published, (double) remaining / 1000.0);
+    }
+    return false;
+}
+
+void ShmReceiver::close() {
+    if (_segment != nullptr) {
+        _header->receiver_slot = _slot;
+        _header->reader.store(0, std::memory_order_release);
+        shared_ring::wake(_header->reader);
+        munmap(_segment, _size);
+        _segment = nullptr;
+        _header = nullptr;
+    }
+}
+
+bool ShmReceiver::isOpen() const {
+    return _header != nullptr && _header->closed.load(std::memory_order_acquire) == 0;
+}
+
+uint64_t ShmReceiver::frames() const {
+    return _frames;
+}
+
+uint64_t ShmReceiver::dropped() const {
+    return _dropped;
+}
@@ -0,0 +1,80 @@
+#ifndef __SHMRECEIVER_HPP
+#define __SHMRECEIVER_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <SharedRing.hpp>
+
+/***
+ * Receives raw frames from a ShmSender on the same machine. Frames are not
+ * copied out of the shared memory segment, a frame stays valid until the
+ * next call of read() as the slot it lives in is only handed back then.
+ * Only a single receiver can attach to a segment at a time, once it has
+ * detached the next one can attach, like a monitor that reconnects.
+ */
+class ShmReceiver {
+public:
+
+    ShmReceiver() = default;
+
+    ShmReceiver(const ShmReceiver &receiver) = delete;
+
+    ~ShmReceiver();
+
+    ShmReceiver& operator=(const ShmReceiver &receiver) = delete;
+
+    /***
+     * attach to the segment of a sender
+     * @param name name of the segment, see shared_ring::name()
+     */
+    void connect(const std::string &name);
+
+    /***
+     * wait for the next frame, frames published in the meantime are skipped
+     * @param frame refers to the segment until the next read
+     * @param timeout in msec
+     * @return false if no frame has arrived within the timeout or the sender has closed the segment,
+     *         the last frame published before closing is still read
+     */
+    bool read(shared_ring::Frame &frame, double timeout=1000.0);
+
+    void close();
+
+    /***
+     * check if attached to a segment that has not been closed by the sender
+     * @return
+     */
+    bool isOpen() const;
+
+    /***
+     * get the number of frames that have been read
+     * @return
+     */
+    uint64_t frames() const;
+
+    /***
+     * get the number of frames that have been skipped because newer ones had been published
+     * @return
+     */
+    uint64_t dropped() const;
+
+private:
+
+    void *_segment = nullptr;
+
+    size_t _size = 0;
+
+    shared_ring::Header *_header = nullptr;
+
+    uint32_t _slot = shared_ring::RECEIVER_SLOT;
+
+    uint64_t _last = 0;
+
+    uint64_t _frames = 0;
+
+    uint64_t _dropped = 0;
+
+};
+
+#endif // __SHMRECEIVER_HPP
@@ -0,0 +1,109 @@
+#include <ShmSender.hpp>
+#include <new>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+ShmSender::~ShmSender() {
+    close();
+}
+
+void ShmSender::open(const std::string &name, size_t capacity) {
+    close();
+    // a segment left behind by a sender that has not been shut down
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error(name + ": " + std::strerror(errno));
+    }
+    const size_t size = shared_ring::segment_size(capacity);
+    if (ftruncate(fd, (off_t) size) != 0) {
+        const int error = errno;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error(name + ": " + std::strerror(error));
+    }
+    void *segment = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (segment == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw std::runtime_error(name + ": " + std::strerror(errno));
+    }
+
+    _name = name;
+    _segment = segment;
+    _size = size;
+    _header = new (segment) shared_ring::Header;
+    _header->version = shared_ring::VERSION;
+    _header->capacity = capacity;
+    _header->state = shared_ring::STATE_SLOT;
+    _header->published = 0;
+    _header->reader = 0;
+    _header->receiver_slot = shared_ring::RECEIVER_SLOT;
+    _header->closed = 0;
+    _header->magic.store(shared_ring::MAGIC, std::memory_order_release);
+    _slot = shared_ring::SENDER_SLOT;
+    _frames = 0;
+}
+
+void ShmSender::waitForReceiver() {
+    if (_header == nullptr) {
+        throw std::runtime_error("shared memory segment not open");
+    }
+    while (_header->reader.load(std::memory_order_acquire) == 0) {
+        shared_ring::wait(_header->reader, 0, -1.0);
+    }
+}
+
+unsigned char* ShmSender::acquire(size_t size) {
+    if (_header == nullptr) {
+        throw std::runtime_error("shared memory segment not open");
+    }
+    if (size > _header->capacity) {
+        throw std::invalid_argument("frame exceeds capacity of shared memory slot");
+    }
+    return shared_ring::data(shared_ring::slot(_segment, _slot));
+}
+
+bool ShmSender::publish(int rows, int cols, int type, size_t step, uint64_t tag) {
+    if (!isOpen()) {
+        return false;
+    }
+    shared_ring::Slot *slot = shared_ring::slot(_segment, _slot);
+    slot->seq = ++_frames;
+    slot->rows = rows;
+    slot->cols = cols;
+    slot->type = type;
+    slot->step = step;
+    slot->size = (uint64_t) rows * step;
+    slot->tag = tag;
+
+    // hand the slot over, the receiver's old one or the unread frame comes back
+    const uint32_t previous = _header->state.exchange(_slot | shared_ring::FRESH, std::memory_order_acq_rel);
+    _slot = previous & ~shared_ring::FRESH;
+    _header->published.fetch_add(1, std::memory_order_release);
+    shared_ring::wake(_header->published);
+    return true;
+}
+
+void ShmSender::close() {
+    if (_segment != nullptr) {
+        _header->closed.store(1, std::memory_order_release);
+        shared_ring::wake(_header->published);
+        munmap(_segment, _size);
+        shm_unlink(_name.c_str());
+        _segment = nullptr;
+        _header = nullptr;
+    }
+}
+
+bool ShmSender::isOpen() const {
+    return _header != nullptr && _header->reader.load(std::memory_order_acquire) != 0;
+}
+
+uint64_t ShmSender::frames() const {
+    return _frames;
+}
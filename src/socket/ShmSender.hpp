@@ -0,0 +1,87 @@
+#ifndef __SHMSENDER_HPP
+#define __SHMSENDER_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <SharedRing.hpp>
+
+/***
+ * Passes raw frames to a ShmReceiver on the same machine through a POSIX
+ * shared memory segment, nothing is encoded and nothing goes through the
+ * network stack. A frame is written straight into a slot of the segment
+ * and published by handing the slot over, see SharedRing.hpp.
+ * The segment is created by open() and removed again by close().
+ */
+class ShmSender {
+public:
+
+    ShmSender() = default;
+
+    ShmSender(const ShmSender &sender) = delete;
+
+    ~ShmSender();
+
+    ShmSender& operator=(const ShmSender &sender) = delete;
+
+    /***
+     * create the segment, a stale segment of the same name is replaced
+     * @param name name of the segment, see shared_ring::name()
+     * @param capacity largest frame in bytes
+     */
+    void open(const std::string &name, size_t capacity=shared_ring::DEFAULT_CAPACITY);
+
+    /***
+     * wait until a receiver has attached to the segment
+     */
+    void waitForReceiver();
+
+    /***
+     * get the memory the next frame is written into
+     * @param size of the frame in bytes
+     * @return
+     */
+    unsigned char* acquire(size_t size);
+
+    /***
+     * publish the frame that has been written into the acquired memory
+     * @param rows
+     * @param cols
+     * @param type OpenCV type of the frame
+     * @param step bytes per row
+     * @param tag passed on to the receiver with the frame, e.g. the frame number the detections refer to
+     * @return false if the receiver has detached
+     */
+    bool publish(int rows, int cols, int type, size_t step, uint64_t tag=0);
+
+    void close();
+
+    /***
+     * check if the segment exists and a receiver is attached
+     * @return
+     */
+    bool isOpen() const;
+
+    /***
+     * get the number of frames that have been published
+     * @return
+     */
+    uint64_t frames() const;
+
+private:
+
+    std::string _name;
+
+    void *_segment = nullptr;
+
+    size_t _size = 0;
+
+    shared_ring::Header *_header = nullptr;
+
+    uint32_t _slot = shared_ring::SENDER_SLOT;
+
+    uint64_t _frames = 0;
+
+};
+
+#endif // __SHMSENDER_HPP
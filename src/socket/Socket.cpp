@@ -1,87 +1,443 @@
 #include "Socket.hpp"
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
 
-boost::asio::io_service io_service;
+using boost::asio::ip::tcp;
 
-Socket* Socket::accept(Socket::protocol_t protocol, unsigned int port) {
-    return accept(io_service, protocol, port);
+struct Socket::Context {
+
+    struct SendOp {
+
+        // bytes owned by the operation, or buffers the caller keeps valid, or a writer
+        bool owned = false;
+
+        std::vector<unsigned char> data;
+
+        std::vector<boost::asio::const_buffer> buffers;
+
+        protocol::Writer *writer = nullptr;
+
+        handler_t done;
+
+    };
+
+    struct RecvOp {
+
+        // a number of bytes into data, or a protocol message into header and payload
+        bool message = false;
+
+        void *data = nullptr;
+
+        size_t size = 0;
+
+        protocol::Header *header = nullptr;
+
+        std::vector<unsigned char> *payload = nullptr;
+
+        handler_t done;
+
+    };
+
+    Context() :
+            work(boost::asio::make_work_guard(context)), socket(context) {}
+
+    void start() {
+        open = true;
+        thread = std::thread([this]{ context.run(); });
+    }
+
+    void post(SendOp &&op) {
+        boost::asio::post(context, [this, op = std::move(op)]() mutable {
+            sends.push_back(std::move(op));
+            if (sends.size() == 1) {
+                nextSend();
+            }
+        });
+    }
+
+    void post(RecvOp &&op) {
+        boost::asio::post(context, [this, op = std::move(op)]() mutable {
+            recvs.push_back(std::move(op));
+            if (recvs.size() == 1) {
+                nextRecv();
+            }
+        });
+    }
+
+    // the peer has closed or reset the connection, nothing can be sent or received anymore
+    void lost(const error_code &error) {
+        if (error == boost::asio::error::eof || error == boost::asio::error::connection_reset
+            || error == boost::asio::error::broken_pipe) {
+            open = false;
+        }
+    }
+
+    // the operation at the front of a queue is in progress, it is removed once it has completed
+
+    void nextSend() {
+        SendOp &op = sends.front();
+        const handler_t done = [this](const error_code &error, size_t n) {
+            lost(error);
+            SendOp completed = std::move(sends.front());
+            sends.pop_front();
+            if (completed.done) {
+                completed.done(error, n);
+            }
+            if (!sends.empty()) {
+                nextSend();
+            }
+        };
+        if (op.writer != nullptr) {
+            op.writer->setPolicy(policy);
+            op.writer->async_write(socket, done);
+        } else if (op.owned) {
+            framing::async_write(socket, { boost::asio::buffer(op.data) }, policy, done);
+        } else {
+            framing::async_write(socket, op.buffers, policy, done);
+        }
+    }
+
+    void nextRecv() {
+        RecvOp &op = recvs.front();
+        const handler_t done = [this](const error_code &error, size_t n) {
+            lost(error);
+            RecvOp completed = std::move(recvs.front());
+            recvs.pop_front();
+            if (completed.done) {
+                completed.done(error, n);
+            }
+            if (!recvs.empty()) {
+                nextRecv();
+            }
+        };
+        if (!op.message) {
+            boost::asio::async_read(socket, boost::asio::buffer(op.data, op.size), done);
+            return;
+        }
+        boost::asio::async_read(socket, boost::asio::buffer(op.header, protocol::HEADER_SIZE),
+                                [this, done](const error_code &error, size_t) {
+            if (error) {
+                done(error, 0);
+                return;
+            }
+            RecvOp &op = recvs.front();
+            protocol::swap(*op.header);
+            if (!protocol::valid(*op.header)) {
+                // the stream cannot be resynchronized
+                done(boost::asio::error::invalid_argument, 0);
+                return;
+            }
+            op.payload->resize(op.header->length);
+            boost::asio::async_read(socket, boost::asio::buffer(*op.payload), done);
+        });
+    }
+
+    boost::asio::io_context context;
+
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work;
+
+    tcp::socket socket;
+
+    std::thread thread;
+
+    std::atomic_bool open { false };
+
+    // only used from the socket's thread
+    framing::policy_t policy = framing::NAGLE;
+
+    std::deque<SendOp> sends;
+
+    std::deque<RecvOp> recvs;
+
+};
+
+// completion handler that fulfils a promise, failures are thrown from the future as std::runtime_error
+static Socket::handler_t fulfil(const std::shared_ptr<std::promise<size_t>> &promise) {
+    return [promise](const Socket::error_code &error, size_t n) {
+        if (error) {
+            promise->set_exception(std::make_exception_ptr(std::runtime_error(error.message())));
+        } else {
+            promise->set_value(n);
+        }
+    };
 }
 
-Socket* Socket::accept(boost::asio::io_service &service, Socket::protocol_t protocol, unsigned int port) {
-    auto socket = new Socket();
-    socket->_type = SERVER;
-    socket->_protocol = protocol;
-    socket->_io_service = &service;
-    socket->_acceptor = new tcp::acceptor(service, tcp::endpoint(protocol == IPv4 ? tcp::v4() : tcp::v6(), port));
-    boost::asio::socket_base::reuse_address option(true);
-    socket->_acceptor->set_option(option);
-    socket->_socket = new tcp::socket(service);
-    try {
-        socket->_acceptor->accept(*socket->_socket);
-    } catch (std::exception &ex) {
-        throw std::runtime_error(ex.what());
+Socket::transport_t Socket::transport_from_string(const std::string &str) {
+    if (string::iequals(str, "TCP")) {
+        return TCP;
+    } else if (string::iequals(str, "UDP")) {
+        return UDP;
+    } else if (string::iequals(str, "SHM")) {
+        return SHM;
+    } else {
+        throw std::invalid_argument("unknown transport '" + str + "'");
     }
-    return socket;
 }
 
-Socket* Socket::connect(const std::string &address, unsigned int port) {
-    return connect(io_service, address, port);
+Socket Socket::accept(Socket::protocol_t protocol, unsigned int port) {
+    std::unique_ptr<Context> context(new Context);
+    const tcp::endpoint endpoint(protocol == IPv4 ? tcp::v4() : tcp::v6(), (unsigned short) port);
+    tcp::acceptor acceptor(context->context);
+    error_code error;
+    acceptor.open(endpoint.protocol(), error);
+    if (!error) {
+        // must be set before binding to take effect
+        acceptor.set_option(boost::asio::socket_base::reuse_address(true), error);
+    }
+    if (!error && protocol == IPv6) {
+        // dual stack, IPv4 clients connect with mapped addresses
+        acceptor.set_option(boost::asio::ip::v6_only(false), error);
+    }
+    if (!error) {
+        acceptor.bind(endpoint, error);
+    }
+    if (!error) {
+        acceptor.listen(boost::asio::socket_base::max_listen_connections, error);
+    }
+    if (!error) {
+        acceptor.accept(context->socket, error);
+    }
+    if (error) {
+        throw std::runtime_error(error.message());
+    }
+    context->start();
+    return Socket(std::move(context), SERVER, protocol);
 }
 
-Socket* Socket::connect(boost::asio::io_service &service, const std::string &address, unsigned int port) {
-    auto socket = new Socket();
-    socket->_type = CLIENT;
-    socket->_io_service = &service;
-    socket->_socket = new tcp::socket(io_service);
-    try {
-        socket->_socket->connect(tcp::endpoint(boost::asio::ip::address::from_string(address), port));
-    } catch (std::exception &ex) {
-        throw std::runtime_error(ex.what());
+Socket Socket::connect(const std::string &host, unsigned int port) {
+    std::unique_ptr<Context> context(new Context);
+    tcp::resolver resolver(context->context);
+    error_code error;
+    const auto endpoints = resolver.resolve(host, std::to_string(port), error);
+    if (!error) {
+        boost::asio::connect(context->socket, endpoints, error);
     }
-    return socket;
+    if (error) {
+        throw std::runtime_error(host + ": " + error.message());
+    }
+    const protocol_t protocol = context->socket.remote_endpoint(error).address().is_v6() ? IPv6 : IPv4;
+    context->start();
+    return Socket(std::move(context), CLIENT, protocol);
 }
 
+Socket::Socket() = default;
+
+Socket::Socket(std::unique_ptr<Context> &&context, int type, Socket::protocol_t protocol) :
+        _context(std::move(context)), _protocol(protocol), _type(type) {}
+
+Socket::Socket(Socket &&socket) noexcept :
+        _context(std::move(socket._context)), _protocol(socket._protocol), _type(socket._type) {}
+
 Socket::~Socket() {
     close();
 }
 
+Socket& Socket::operator=(Socket &&socket) noexcept {
+    if (this != &socket) {
+        close();
+        _context = std::move(socket._context);
+        _protocol = socket._protocol;
+        _type = socket._type;
+    }
+    return *this;
+}
+
 bool Socket::isOpen() const {
-    return _socket->is_open();
+    return _context && _context->open;
 }
 
-size_t Socket::send(const void *buffer, size_t len) {
-    if (_socket->is_open()) {
-        boost::system::error_code error;
-        size_t s = boost::asio::write(*_socket, boost::asio::const_buffer(buffer, len), error);
+void Socket::asyncSend(std::vector<unsigned char> data, const Socket::handler_t &handler) {
+    if (!isOpen()) {
+        if (handler) {
+            handler(boost::asio::error::not_connected, 0);
+        }
+        return;
+    }
+    Context::SendOp op;
+    op.owned = true;
+    op.data = std::move(data);
+    op.done = handler;
+    _context->post(std::move(op));
+}
+
+std::future<size_t> Socket::asyncSend(std::vector<unsigned char> data) {
+    auto promise = std::make_shared<std::promise<size_t>>();
+    asyncSend(std::move(data), fulfil(promise));
+    return promise->get_future();
+}
+
+void Socket::asyncSend(protocol::Writer &writer, const Socket::handler_t &handler) {
+    if (!isOpen()) {
+        if (handler) {
+            handler(boost::asio::error::not_connected, 0);
+        }
+        return;
+    }
+    Context::SendOp op;
+    op.writer = &writer;
+    op.done = handler;
+    _context->post(std::move(op));
+}
+
+void Socket::asyncRecv(size_t len, const Socket::recv_handler_t &handler) {
+    if (!isOpen()) {
+        std::vector<unsigned char> data;
+        if (handler) {
+            handler(boost::asio::error::not_connected, data);
+        }
+        return;
+    }
+    auto data = std::make_shared<std::vector<unsigned char>>(len);
+    Context::RecvOp op;
+    op.data = data->data();
+    op.size = len;
+    op.done = [data, handler](const error_code &error, size_t) {
+        if (handler) {
+            handler(error, *data);
+        }
+    };
+    _context->post(std::move(op));
+}
+
+std::future<std::vector<unsigned char>> Socket::asyncRecv(size_t len) {
+    auto promise = std::make_shared<std::promise<std::vector<unsigned char>>>();
+    asyncRecv(len, [promise](const error_code &error, std::vector<unsigned char> &data) {
         if (error) {
-            throw std::runtime_error(error.message());
+            promise->set_exception(std::make_exception_ptr(std::runtime_error(error.message())));
+        } else {
+            promise->set_value(std::move(data));
         }
-        return s;
-    } else {
-        throw std::runtime_error("socket not opened");
+    });
+    return promise->get_future();
+}
+
+void Socket::asyncRecv(const Socket::message_handler_t &handler) {
+    if (!isOpen()) {
+        Message message;
+        if (handler) {
+            handler(boost::asio::error::not_connected, message);
+        }
+        return;
     }
+    auto message = std::make_shared<Message>();
+    Context::RecvOp op;
+    op.message = true;
+    op.header = &message->header;
+    op.payload = &message->payload;
+    op.done = [message, handler](const error_code &error, size_t) {
+        if (handler) {
+            handler(error, *message);
+        }
+    };
+    _context->post(std::move(op));
 }
 
-size_t Socket::recv(void *buffer, size_t len) {
-    if (_socket->is_open()) {
-        boost::system::error_code error;
-        size_t s = boost::asio::read(*_socket, boost::asio::buffer(buffer, len), error);
+std::future<Socket::Message> Socket::asyncRecv() {
+    auto promise = std::make_shared<std::promise<Message>>();
+    asyncRecv([promise](const error_code &error, Message &message) {
         if (error) {
-            throw std::runtime_error(error.message());
+            promise->set_exception(std::make_exception_ptr(std::runtime_error(error.message())));
+        } else {
+            promise->set_value(std::move(message));
         }
-        return s;
-    } else {
+    });
+    return promise->get_future();
+}
+
+size_t Socket::send(const void *buffer, size_t len) {
+    if (!isOpen()) {
+        throw std::runtime_error("socket not opened");
+    }
+    // the caller's memory is written from, it stays valid while waiting
+    auto promise = std::make_shared<std::promise<size_t>>();
+    Context::SendOp op;
+    op.buffers.emplace_back(buffer, len);
+    op.done = fulfil(promise);
+    _context->post(std::move(op));
+    return promise->get_future().get();
+}
+
+size_t Socket::send(const framing::Message &message) {
+    if (!isOpen()) {
+        throw std::runtime_error("socket not opened");
+    }
+    auto promise = std::make_shared<std::promise<size_t>>();
+    Context::SendOp op;
+    op.buffers = message.buffers();
+    op.done = fulfil(promise);
+    _context->post(std::move(op));
+    return promise->get_future().get();
+}
+
+size_t Socket::send(protocol::Writer &writer) {
+    if (!isOpen()) {
+        throw std::runtime_error("socket not opened");
+    }
+    auto promise = std::make_shared<std::promise<size_t>>();
+    asyncSend(writer, fulfil(promise));
+    return promise->get_future().get();
+}
+
+size_t Socket::recv(void *buffer, size_t len) {
+    if (!isOpen()) {
         throw std::runtime_error("socket not opened");
     }
+    auto promise = std::make_shared<std::promise<size_t>>();
+    Context::RecvOp op;
+    op.data = buffer;
+    op.size = len;
+    op.done = fulfil(promise);
+    _context->post(std::move(op));
+    return promise->get_future().get();
 }
+
+void Socket::recv(protocol::Header &header, std::vector<unsigned char> &payload) {
+    if (!isOpen()) {
+        throw std::runtime_error("socket not opened");
+    }
+    auto promise = std::make_shared<std::promise<size_t>>();
+    Context::RecvOp op;
+    op.message = true;
+    op.header = &header;
+    op.payload = &payload;
+    op.done = fulfil(promise);
+    _context->post(std::move(op));
+    promise->get_future().get();
+}
+
+void Socket::setPolicy(framing::policy_t policy) {
+    execute([this, policy] {
+        framing::set_policy(_context->socket, policy);
+        _context->policy = policy;
+    });
+}
+
 void Socket::close() {
-    _socket->close();
-    delete _acceptor;
-    delete _socket;
-    _io_service = nullptr;
+    if (!_context) {
+        return;
+    }
+    _context->open = false;
+    Context *context = _context.get();
+    boost::asio::post(context->context, [context] {
+        // operations in progress complete with operation_aborted, queued ones fail right away
+        error_code error;
+        context->socket.shutdown(tcp::socket::shutdown_both, error);
+        context->socket.close(error);
+    });
+    // the thread returns once all operations have completed
+    context->work.reset();
+    if (context->thread.joinable()) {
+        context->thread.join();
+    }
+    _context.reset();
 }
 
 size_t Socket::available() const {
-    return _socket->available();
+    size_t n = 0;
+    execute([this, &n] { n = _context->socket.available(); });
+    return n;
 }
 
 int Socket::type() const {
@@ -91,3 +447,19 @@ int Socket::type() const {
 Socket::protocol_t Socket::protocol() const {
     return _protocol;
 }
+
+void Socket::execute(const std::function<void ()> &f) const {
+    if (!isOpen()) {
+        throw std::runtime_error("socket not opened");
+    }
+    std::promise<void> promise;
+    boost::asio::post(_context->context, [&promise, &f] {
+        try {
+            f();
+            promise.set_value();
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    });
+    promise.get_future().get();
+}
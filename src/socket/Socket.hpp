@@ -3,10 +3,29 @@
 
 #include <boost/asio.hpp>
 #include <type_traits>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
 #include <common.hpp>
-
-using boost::asio::ip::tcp;
-
+#include <Framing.hpp>
+#include <Protocol.hpp>
+
+/***
+ * Connected TCP socket that owns its connection. Every socket runs its own
+ * io_context on a dedicated thread, all reads and writes are done there:
+ * sends and receives are queued and carried out one after another in the
+ * order they have been issued, their completion is reported to a callback,
+ * called from the socket's thread, or through a future.
+ * On a closed socket the callback is called right away with not_connected.
+ * The blocking send() and recv() wait for such a future and throw a
+ * std::runtime_error if the operation failed, they must not be called from
+ * a callback, neither may the socket be closed or destroyed from one and
+ * callbacks must not throw.
+ * A socket can be moved but not copied, a default constructed or
+ * moved from socket is closed.
+ */
 class Socket {
 public:
     enum {
@@ -19,20 +38,109 @@ public:
         IPv6 = 1
     };
 
+    // transport of the video stream, UDP drops frames instead of delaying them,
+    // SHM passes raw frames through shared memory to a receiver on the same machine
+    enum transport_t {
+        TCP = 0,
+        UDP = 1,
+        SHM = 2
+    };
+
     typedef boost::system::error_code   error_code;
 
-    static Socket* accept(protocol_t protocol, unsigned int port);
+    // completion of a send with the number of bytes written
+    typedef framing::handler_t          handler_t;
+
+    // completion of a receive, the data may be moved out of the vector
+    typedef std::function<void (const error_code&, std::vector<unsigned char>&)>   recv_handler_t;
+
+    struct Message {
+
+        // in host byte order
+        protocol::Header header;
+
+        std::vector<unsigned char> payload;
+
+    };
+
+    // completion of receiving a protocol message, the message may be moved out
+    typedef std::function<void (const error_code&, Message&)>  message_handler_t;
+
+    /***
+     * get the transport from a string, "TCP", "UDP" or "SHM"
+     * @param str
+     * @return
+     */
+    static transport_t transport_from_string(const std::string &str);
+
+    /***
+     * wait for a client to connect
+     * @param protocol IPv6 accepts IPv4 clients as well
+     * @param port
+     * @return connected socket
+     */
+    static Socket accept(protocol_t protocol, unsigned int port);
+
+    /***
+     * connect to a server, the host is resolved and every address it resolves to is tried
+     * @param host name, IPv4 or IPv6 address
+     * @param port
+     * @return connected socket
+     */
+    static Socket connect(const std::string &host, unsigned int port);
 
-    static Socket* accept(boost::asio::io_service &service, protocol_t protocol, unsigned int port);
+    Socket();
 
-    static Socket* connect(const std::string &address, unsigned int port);
+    Socket(const Socket &socket) = delete;
 
-    static Socket* connect(boost::asio::io_service &service, const std::string &address, unsigned int port);
+    Socket(Socket &&socket) noexcept;
 
     ~Socket();
 
+    Socket& operator=(const Socket &socket) = delete;
+
+    Socket& operator=(Socket &&socket) noexcept;
+
+    /***
+     * check if the socket can be used, it is closed by close() and as soon as a
+     * send or receive has found the connection closed or reset by the peer
+     * @return
+     */
     bool isOpen() const;
 
+    /***
+     * queue data for sending
+     * @param data
+     * @param handler
+     */
+    void asyncSend(std::vector<unsigned char> data, const handler_t &handler);
+
+    std::future<size_t> asyncSend(std::vector<unsigned char> data);
+
+    /***
+     * queue all messages of a writer for sending with a single gather write
+     * @param writer must not be used until the handler has been called
+     * @param handler
+     */
+    void asyncSend(protocol::Writer &writer, const handler_t &handler);
+
+    /***
+     * queue receiving a number of bytes
+     * @param len
+     * @param handler
+     */
+    void asyncRecv(size_t len, const recv_handler_t &handler);
+
+    std::future<std::vector<unsigned char>> asyncRecv(size_t len);
+
+    /***
+     * queue receiving the next protocol message
+     * @param handler
+     */
+    void asyncRecv(const message_handler_t &handler);
+
+    std::future<Message> asyncRecv();
+
     size_t send(const void *buffer, size_t len);
 
     template <typename T>
@@ -46,8 +154,29 @@ public:
         }
     }
 
+    /***
+     * send a whole framed message with a single gather write
+     * @param message
+     * @return number of bytes sent
+     */
+    size_t send(const framing::Message &message);
+
+    /***
+     * send all messages of the writer with a single gather write
+     * @param writer
+     * @return number of bytes sent
+     */
+    size_t send(protocol::Writer &writer);
+
     size_t recv(void *buffer, size_t len);
 
+    /***
+     * receive the next protocol message
+     * @param header set to the header in host byte order
+     * @param payload overwritten with the payload
+     */
+    void recv(protocol::Header &header, std::vector<unsigned char> &payload);
+
     template <typename T>
     size_t recv(T &x) {
         static_assert(std::is_fundamental<T>::value || std::is_arithmetic<T>::value, "can only receive basic types directly");
@@ -60,6 +189,16 @@ public:
         }
     }
 
+    /***
+     * set the policy of how small segments are handled, see framing::policy_t
+     * @param policy
+     */
+    void setPolicy(framing::policy_t policy);
+
+    /***
+     * close the connection, operations still queued complete with an error,
+     * then the socket's thread is joined
+     */
     void close();
 
     size_t available() const;
@@ -70,13 +209,17 @@ public:
 
 private:
 
-    Socket() = default;
+    struct Context;
 
-    boost::asio::io_service *_io_service = nullptr;
+    Socket(std::unique_ptr<Context> &&context, int type, protocol_t protocol);
 
-    tcp::acceptor *_acceptor = nullptr;
+    /***
+     * run a function on the socket's thread and wait for it
+     * @param f
+     */
+    void execute(const std::function<void ()> &f) const;
 
-    tcp::socket *_socket = nullptr;
+    std::unique_ptr<Context> _context;
 
     protocol_t _protocol = IPv4;
 
@@ -84,14 +227,14 @@ private:
 
 };
 
-Socket& operator<<(Socket &socket, const std::string &x) {
+inline Socket& operator<<(Socket &socket, const std::string &x) {
     const uint32_t s = x.size();
     socket.send<uint32_t>(s);
     socket.send((const void *) x.data(), x.size());
     return socket;
 }
 
-Socket& operator>>(Socket &socket, std::string &x) {
+inline Socket& operator>>(Socket &socket, std::string &x) {
     uint32_t s = 0;
     socket.recv<uint32_t>(s);
     x.resize(s);
@@ -0,0 +1,232 @@
+#include <UdpReceiver.hpp>
+#include <Protocol.hpp>
+#include <poll.h>
+#include <cstring>
+#include <cstdlib>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+using boost::asio::ip::udp;
+
+// interval the hello is repeated in until the sender answers
+static const auto HELLO_INTERVAL = std::chrono::milliseconds(200);
+
+// frame ids wrap around
+static inline bool newer(uint32_t a, uint32_t b) {
+    return (int32_t) (a - b) > 0;
+}
+
+double UdpReceiver::Stats::loss() const {
+    const uint64_t total = fragments + lost_fragments;
+    return total > 0 ? double(lost_fragments) / double(total) : 0.0;
+}
+
+UdpReceiver::UdpReceiver() :
+        _socket(_service), _datagram(65536) {}
+
+UdpReceiver::~UdpReceiver() {
+    close();
+}
+
+void UdpReceiver::connect(const std::string &host, unsigned short port) {
+    close();
+    boost::system::error_code error;
+    udp::resolver resolver(_service);
+    const auto it = resolver.resolve(udp::resolver::query(udp::v4(), host, std::to_string(port)), error);
+    if (!error) {
+        _sender = *it;
+        _socket.open(udp::v4(), error);
+    }
+    if (error) {
+        throw std::runtime_error(error.message());
+    }
+    _partials.clear();
+    _delivered = false;
+    _seen = false;
+    _frames_seen = 0;
+    _fragments_seen = 0;
+    _stats = Stats();
+    hello();
+}
+
+void UdpReceiver::setDeadline(double ms) {
+    _deadline = std::chrono::microseconds((int64_t) (ms * 1000.0));
+}
+
+void UdpReceiver::requestKeyframe() {
+    hello();
+}
+
+bool UdpReceiver::read(std::vector<unsigned char> &frame, double timeout) {
+    const auto end = std::chrono::steady_clock::now() + std::chrono::microseconds((int64_t) (timeout * 1000.0));
+    auto last_hello = std::chrono::steady_clock::now();
+    while (isOpen()) {
+        expire();
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= end) {
+            return false;
+        }
+
+        // wait for a datagram in short steps, incomplete frames must be expired meanwhile
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(end - now).count();
+        pollfd pfd = { _socket.native_handle(), POLLIN, 0 };
+        if (::poll(&pfd, 1, (int) std::min<int64_t>(std::max<int64_t>(remaining, 1), 20)) <= 0) {
+            if (!_seen && now - last_hello >= HELLO_INTERVAL) {
+                hello();
+                last_hello = now;
+            }
+            continue;
+        }
+
+        boost::system::error_code error;
+        udp::endpoint from;
+        const size_t n = _socket.receive_from(boost::asio::buffer(_datagram), from, 0, error);
+        if (error == boost::asio::error::connection_refused) {
+            // the sender is not up yet
+            continue;
+        } else if (error) {
+            return false;
+        }
+        if (push(_datagram.data(), n, frame)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void UdpReceiver::close() {
+    boost::system::error_code error;
+    _socket.close(error);
+}
+
+bool UdpReceiver::isOpen() const {
+    return _socket.is_open();
+}
+
+uint32_t UdpReceiver::tag() const {
+    return _tag;
+}
+
+UdpReceiver::Stats UdpReceiver::stats() const {
+    return _stats;
+}
+
+void UdpReceiver::hello() {
+    const uint32_t hello = inet_bswap(fragment::HELLO);
+    boost::system::error_code error;
+    _socket.send_to(boost::asio::buffer(&hello, sizeof(hello)), _sender, 0, error);
+}
+
+bool UdpReceiver::push(const unsigned char *datagram, size_t size, std::vector<unsigned char> &frame) {
+    if (size < fragment::HEADER_SIZE) {
+        return false;
+    }
+    fragment::Header header;
+    std::memcpy(&header, datagram, sizeof(header));
+    protocol::swap_batch(&header, 1);
+
+    const size_t length = size - fragment::HEADER_SIZE;
+    if (header.count == 0 || header.index >= header.count || header.frame_size > fragment::MAX_FRAME_SIZE
+        || length > header.frame_size) {
+        return false;
+    }
+    // all fragments but the last one have the same size
+    const size_t offset = header.index + 1 == header.count ? header.frame_size - length : (size_t) header.index * length;
+    if (offset + length > header.frame_size) {
+        return false;
+    }
+    _stats.fragments += 1;
+
+    // jitter of the transit times, the clocks of sender and receiver do not have to be in sync
+    const auto transit = (int64_t) (int32_t) ((uint32_t) protocol::now() - header.timestamp);
+    if (_stats.fragments > 1) {
+        const double d = (double) std::llabs(transit - _transit) / 1000.0;
+        _stats.jitter += (d - _stats.jitter) / 16.0;
+    }
+    _transit = transit;
+
+    if (!_seen || newer(header.frame_id, _newest)) {
+        // frames in between of which not a single fragment has arrived, with as many fragments as the others
+        if (_seen) {
+            const uint32_t lost = header.frame_id - _newest - 1;
+            const double fragments = _frames_seen > 0 ? double(_fragments_seen) / double(_frames_seen) : header.count;
+            _stats.incomplete += lost;
+            _stats.lost_frames += lost;
+            _stats.lost_fragments += (uint64_t) std::llround(lost * fragments);
+        }
+        _newest = header.frame_id;
+        _seen = true;
+    }
+    if (_delivered && !newer(header.frame_id, _last)) {
+        // frame has been delivered or discarded already
+        _stats.late += 1;
+        return false;
+    }
+
+    auto it = _partials.find(header.frame_id);
+    if (it == _partials.end()) {
+        Partial partial;
+        partial.data.resize(header.frame_size);
+        partial.received.assign(header.count, false);
+        partial.missing = header.count;
+        partial.tag = header.tag;
+        partial.first = std::chrono::steady_clock::now();
+        it = _partials.emplace(header.frame_id, std::move(partial)).first;
+        _frames_seen += 1;
+        _fragments_seen += header.count;
+    }
+    auto &partial = it->second;
+    if (partial.received.size() != header.count || partial.data.size() != header.frame_size
+        || partial.received[header.index]) {
+        return false;
+    }
+    std::memcpy(partial.data.data() + offset, datagram + fragment::HEADER_SIZE, length);
+    partial.received[header.index] = true;
+    partial.missing -= 1;
+    if (partial.missing > 0) {
+        return false;
+    }
+
+    frame.swap(partial.data);
+    _tag = partial.tag;
+    _last = header.frame_id;
+    _delivered = true;
+    _stats.frames += 1;
+
+    _partials.erase(it);
+
+    // older frames would be delivered out of order
+    for (auto p = _partials.begin(); p != _partials.end();) {
+        if (newer(_last, p->first)) {
+            discard(p++);
+        } else {
+            ++p;
+        }
+    }
+    return true;
+}
+
+void UdpReceiver::discard(std::map<uint32_t, Partial>::iterator it) {
+    _stats.incomplete += 1;
+    _stats.lost_fragments += it->second.missing;
+    _partials.erase(it);
+}
+
+void UdpReceiver::expire() {
+    const auto now = std::chrono::steady_clock::now();
+    for (auto it = _partials.begin(); it != _partials.end();) {
+        if (now - it->second.first > _deadline) {
+            discard(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::ostream& operator<<(std::ostream &os, const UdpReceiver::Stats &stats) {
+    return os << "frames=" << stats.frames << " incomplete=" << stats.incomplete << " (lost=" << stats.lost_frames
+              << ") late=" << stats.late
+              << " fragments=" << stats.fragments << " lost=" << stats.lost_fragments
+              << " loss=" << stats.loss() * 100.0 << "% jitter=" << stats.jitter << "ms";
+}
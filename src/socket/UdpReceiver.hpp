@@ -0,0 +1,164 @@
+#ifndef __UDPRECEIVER_HPP
+#define __UDPRECEIVER_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <boost/asio.hpp>
+#include <Fragment.hpp>
+
+/***
+ * Receives frames sent by a UdpSender and reassembles them from their
+ * fragments. A frame that is not complete within the deadline after its
+ * first fragment has arrived is discarded, so is every incomplete frame
+ * older than a frame that has been completed, frames are never delivered
+ * out of order.
+ * Loss and the interarrival jitter of the datagrams are recorded.
+ */
+class UdpReceiver {
+public:
+
+    struct Stats {
+
+        // frames that have been delivered
+        uint64_t frames = 0;
+
+        // frames discarded because fragments were missing, including frames of which nothing arrived
+        uint64_t incomplete = 0;
+
+        // fragments that arrived after their frame had been delivered or discarded
+        uint64_t late = 0;
+
+        // datagrams that have been received
+        uint64_t fragments = 0;
+
+        // frames of which not a single fragment has arrived, they are counted as incomplete as well
+        uint64_t lost_frames = 0;
+
+        // fragments of discarded frames that did not arrive, those of frames lost entirely
+        // are estimated from the mean number of fragments per frame
+        uint64_t lost_fragments = 0;
+
+        // interarrival jitter in msec, as estimated by RFC 3550
+        double jitter = 0.0;
+
+        /***
+         * get the fraction of fragments that have been lost
+         * @return
+         */
+        double loss() const;
+
+    };
+
+    UdpReceiver();
+
+    UdpReceiver(const UdpReceiver &receiver) = delete;
+
+    ~UdpReceiver();
+
+    UdpReceiver& operator=(const UdpReceiver &receiver) = delete;
+
+    /***
+     * register with the sender, the hello is repeated until the first fragment arrives
+     * @param host
+     * @param port
+     */
+    void connect(const std::string &host, unsigned short port);
+
+    /***
+     * set the time a frame may take to arrive completely after its first fragment
+     * @param ms
+     */
+    void setDeadline(double ms);
+
+    /***
+     * ask the sender for a keyframe by repeating the hello
+     */
+    void requestKeyframe();
+
+    /***
+     * wait for the next complete frame
+     * @param frame overwritten with the frame
+     * @param timeout in msec
+     * @return false if no frame has been completed within the timeout or the socket is closed
+     */
+    bool read(std::vector<unsigned char> &frame, double timeout=1000.0);
+
+    /***
+     * get the tag the sender has given the last frame read
+     * @return
+     */
+    uint32_t tag() const;
+
+    void close();
+
+    bool isOpen() const;
+
+    Stats stats() const;
+
+private:
+
+    struct Partial {
+
+        std::vector<unsigned char> data;
+
+        std::vector<bool> received;
+
+        uint32_t missing = 0;
+
+        uint32_t tag = 0;
+
+        std::chrono::steady_clock::time_point first;
+
+    };
+
+    void hello();
+
+    bool push(const unsigned char *datagram, size_t size, std::vector<unsigned char> &frame);
+
+    void discard(std::map<uint32_t, Partial>::iterator it);
+
+    void expire();
+
+    boost::asio::io_service _service;
+
+    boost::asio::ip::udp::socket _socket;
+
+    boost::asio::ip::udp::endpoint _sender;
+
+    std::chrono::microseconds _deadline { 100000 };
+
+    // frames being reassembled by frame id
+    std::map<uint32_t, Partial> _partials;
+
+    // id of the newest frame that has been delivered
+    uint32_t _last = 0;
+
+    bool _delivered = false;
+
+    uint32_t _tag = 0;
+
+    // newest frame id a fragment has been seen of, to detect frames that got lost entirely
+    uint32_t _newest = 0;
+
+    bool _seen = false;
+
+    // frames a fragment has arrived of and the sum of their fragment counts, for frames lost entirely
+    uint64_t _frames_seen = 0;
+
+    uint64_t _fragments_seen = 0;
+
+    int64_t _transit = 0;
+
+    std::vector<unsigned char> _datagram;
+
+    Stats _stats;
+
+};
+
+std::ostream& operator<<(std::ostream &os, const UdpReceiver::Stats &stats);
+
+#endif // __UDPRECEIVER_HPP
@@ -0,0 +1,150 @@
+#include <UdpSender.hpp>
+#include <Protocol.hpp>
+#include <array>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+
+using boost::asio::ip::udp;
+
+UdpSender::UdpSender() :
+        _socket(_service), _rng(std::random_device()()) {}
+
+UdpSender::~UdpSender() {
+    close();
+}
+
+void UdpSender::open(unsigned short port) {
+    close();
+    boost::system::error_code error;
+    _socket.open(udp::v4(), error);
+    if (!error) {
+        _socket.bind(udp::endpoint(udp::v4(), port), error);
+    }
+    if (error) {
+        throw std::runtime_error(error.message());
+    }
+}
+
+void UdpSender::waitForReceiver() {
+    uint32_t hello = 0;
+    udp::endpoint sender;
+    while (hello != inet_bswap(fragment::HELLO)) {
+        boost::system::error_code error;
+        const size_t n = _socket.receive_from(boost::asio::buffer(&hello, sizeof(hello)), sender, 0, error);
+        if (error) {
+            throw std::runtime_error(error.message());
+        }
+        if (n != sizeof(hello)) {
+            hello = 0;
+        }
+    }
+    _receiver = sender;
+    _connected = true;
+    _joined = true;
+}
+
+void UdpSender::setDatagramSize(size_t size) {
+    if (size <= fragment::HEADER_SIZE) {
+        throw std::invalid_argument("datagram size too small");
+    }
+    _datagram_size = size;
+}
+
+void UdpSender::setLoss(double probability) {
+    _loss = std::min(std::max(probability, 0.0), 1.0);
+}
+
+bool UdpSender::poll() {
+    // hellos that have arrived meanwhile
+    boost::system::error_code ec;
+    while (_socket.is_open() && _socket.available(ec) > 0 && !ec) {
+        uint32_t hello = 0;
+        udp::endpoint sender;
+        const size_t n = _socket.receive_from(boost::asio::buffer(&hello, sizeof(hello)), sender, 0, ec);
+        if (!ec && n == sizeof(hello) && hello == inet_bswap(fragment::HELLO)) {
+            _receiver = sender;
+            _connected = true;
+            _joined = true;
+        }
+    }
+    return isOpen();
+}
+
+bool UdpSender::send(const void *data, size_t size, uint32_t tag) {
+    if (!poll()) {
+        return false;
+    }
+    if (size > fragment::MAX_FRAME_SIZE) {
+        throw std::invalid_argument("frame too large");
+    }
+
+    const size_t payload = _datagram_size - fragment::HEADER_SIZE;
+    const auto count = (uint32_t) std::max<size_t>(1, (size + payload - 1) / payload);
+    const auto ptr = static_cast<const unsigned char*>(data);
+    std::bernoulli_distribution lose(_loss);
+
+    fragment::Header header;
+    header.frame_id = _frame_id++;
+    header.count = count;
+    header.frame_size = (uint32_t) size;
+    header.tag = tag;
+    for (uint32_t i = 0; i < count; ++i) {
+        const size_t offset = i * payload;
+        const size_t n = std::min(payload, size - offset);
+        _datagrams += 1;
+        if (_loss > 0.0 && lose(_rng)) {
+            _dropped += 1;
+            continue;
+        }
+
+        header.index = i;
+        header.timestamp = (uint32_t) protocol::now();
+        fragment::Header wire = header;
+        protocol::swap_batch(&wire, 1);
+
+        // header and payload are gathered, the frame is not copied
+        const std::array<boost::asio::const_buffer, 2> buffers = {{
+                boost::asio::buffer(&wire, sizeof(wire)), boost::asio::buffer(ptr + offset, n) }};
+        boost::system::error_code error;
+        _socket.send_to(buffers, _receiver, 0, error);
+        // a receiver that is gone or a full buffer only costs this frame
+        if (error && error != boost::asio::error::connection_refused && error != boost::asio::error::no_buffer_space) {
+            return false;
+        }
+    }
+    _frames += 1;
+    return true;
+}
+
+bool UdpSender::send(const std::vector<unsigned char> &frame, uint32_t tag) {
+    return send(frame.data(), frame.size(), tag);
+}
+
+bool UdpSender::joined() {
+    const bool joined = _joined;
+    _joined = false;
+    return joined;
+}
+
+void UdpSender::close() {
+    boost::system::error_code error;
+    _socket.close(error);
+    _connected = false;
+}
+
+bool UdpSender::isOpen() const {
+    return _connected && _socket.is_open();
+}
+
+uint64_t UdpSender::frames() const {
+    return _frames;
+}
+
+uint64_t UdpSender::datagrams() const {
+    return _datagrams;
+}
+
+uint64_t UdpSender::dropped() const {
+    return _dropped;
+}
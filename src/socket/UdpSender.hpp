@@ -0,0 +1,132 @@
+#ifndef __UDPSENDER_HPP
+#define __UDPSENDER_HPP
+
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <boost/asio.hpp>
+#include <Fragment.hpp>
+
+/***
+ * Sends frames as datagrams, every frame is split into fragments that fit
+ * into a single datagram. Datagrams that get lost are not sent again, the
+ * receiver drops the frame instead, so a lost packet never delays the
+ * frames that follow it.
+ * The receiver registers itself with a hello datagram, frames are sent to
+ * the address the last hello came from. A receiver repeats its hello when
+ * it has to start over, e.g. to get a keyframe after it has lost frames.
+ * For testing, datagrams can be dropped on purpose with a given probability.
+ */
+class UdpSender {
+public:
+
+    UdpSender();
+
+    UdpSender(const UdpSender &sender) = delete;
+
+    ~UdpSender();
+
+    UdpSender& operator=(const UdpSender &sender) = delete;
+
+    /***
+     * bind to the port the receiver sends its hello to
+     * @param port
+     */
+    void open(unsigned short port);
+
+    /***
+     * wait until a receiver has registered itself
+     */
+    void waitForReceiver();
+
+    /***
+     * take the hellos that have arrived without waiting, the last one registers its receiver
+     * @return true if a receiver is registered
+     */
+    bool poll();
+
+    /***
+     * set the size of the datagrams including the fragment header
+     * @param size
+     */
+    void setDatagramSize(size_t size);
+
+    /***
+     * drop datagrams on purpose to simulate a lossy link
+     * @param probability in [0, 1], 0 disables it
+     */
+    void setLoss(double probability);
+
+    /***
+     * send a frame, a receiver that has sent its hello meanwhile is registered first
+     * @param data
+     * @param size
+     * @param tag passed on to the receiver with the frame, e.g. the frame number the detections refer to
+     * @return false if no receiver has registered or sending failed
+     */
+    bool send(const void *data, size_t size, uint32_t tag=0);
+
+    bool send(const std::vector<unsigned char> &frame, uint32_t tag=0);
+
+    /***
+     * check if a hello has arrived since the last call, the receiver
+     * has joined again and needs a keyframe
+     * @return
+     */
+    bool joined();
+
+    void close();
+
+    /***
+     * check if a receiver has registered and the socket is open
+     * @return
+     */
+    bool isOpen() const;
+
+    /***
+     * get the number of frames that have been sent
+     * @return
+     */
+    uint64_t frames() const;
+
+    /***
+     * get the number of datagrams that have been sent, including the dropped ones
+     * @return
+     */
+    uint64_t datagrams() const;
+
+    /***
+     * get the number of datagrams that have been dropped on purpose
+     * @return
+     */
+    uint64_t dropped() const;
+
+private:
+
+    boost::asio::io_service _service;
+
+    boost::asio::ip::udp::socket _socket;
+
+    boost::asio::ip::udp::endpoint _receiver;
+
+    bool _connected = false;
+
+    bool _joined = false;
+
+    size_t _datagram_size = fragment::DEFAULT_DATAGRAM_SIZE;
+
+    double _loss = 0.0;
+
+    std::mt19937 _rng;
+
+    uint32_t _frame_id = 0;
+
+    uint64_t _frames = 0;
+
+    uint64_t _datagrams = 0;
+
+    uint64_t _dropped = 0;
+
+};
+
+#endif // __UDPSENDER_HPP
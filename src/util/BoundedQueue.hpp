@@ -0,0 +1,165 @@
+#ifndef __BOUNDEDQUEUE_HPP
+#define __BOUNDEDQUEUE_HPP
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+#include <common.hpp>
+
+/***
+ * Thread-safe FIFO queue with a fixed capacity that is used to hand
+ * items from one pipeline stage to the next.
+ * What happens when an item is pushed into a full queue is determined
+ * by the drop policy, a closed queue wakes up all waiting threads.
+ * @tparam T item type, must be movable
+ */
+template <typename T>
+class BoundedQueue {
+public:
+
+    // behaviour of push() on a full queue
+    enum drop_policy_t {
+        BLOCK = 0,          // wait until the consumer has made room
+        DROP_OLDEST = 1,    // discard the item at the front of the queue
+        DROP_NEWEST = 2     // discard the item that is about to be pushed
+    };
+
+    /***
+     * parse drop policy from its name, ignoring case
+     * @param str one of BLOCK, DROP_OLDEST or DROP_NEWEST
+     * @return
+     */
+    static drop_policy_t policy_from_string(const std::string &str) {
+        if (string::iequals(str, "BLOCK")) {
+            return BLOCK;
+        } else if (string::iequals(str, "DROP_OLDEST")) {
+            return DROP_OLDEST;
+        } else if (string::iequals(str, "DROP_NEWEST")) {
+            return DROP_NEWEST;
+        } else {
+            throw std::invalid_argument("unknown drop policy \'" + str + '\'');
+        }
+    }
+
+    /***
+     * create queue holding at most capacity items
+     * @param capacity must be at least 1
+     * @param policy
+     */
+    explicit BoundedQueue(size_t capacity=1, drop_policy_t policy=BLOCK) :
+            _capacity(capacity), _policy(policy) {
+        if (capacity == 0) {
+            throw std::invalid_argument("queue capacity must be at least 1");
+        }
+    }
+
+    BoundedQueue(const BoundedQueue &queue) = delete;
+
+    BoundedQueue& operator=(const BoundedQueue &queue) = delete;
+
+    /***
+     * push item into the queue, if the queue is full the drop policy applies
+     * @param item
+     * @return false if the queue has been closed or the item was dropped
+     */
+    bool push(T &&item) {
+        std::unique_lock<std::mutex> lock(_mtx);
+        if (_policy == BLOCK) {
+            _not_full.wait(lock, [this]{ return _closed || _queue.size() < _capacity; });
+        }
+        if (_closed) {
+            return false;
+        }
+        if (_queue.size() >= _capacity) {
+            _dropped += 1;
+            if (_policy == DROP_NEWEST) {
+                return false;
+            }
+            _queue.pop_front();
+        }
+        _queue.emplace_back(std::move(item));
+        lock.unlock();
+        _not_empty.notify_one();
+        return true;
+    }
+
+    /***
+     * take the item at the front of the queue, blocks until an
+     * item is available or the queue is closed
+     * @param item
+     * @return false if the queue has been closed and is empty
+     */
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _not_empty.wait(lock, [this]{ return _closed || !_queue.empty(); });
+        if (_queue.empty()) {
+            return false;
+        }
+        item = std::move(_queue.front());
+        _queue.pop_front();
+        lock.unlock();
+        _not_full.notify_one();
+        return true;
+    }
+
+    /***
+     * close the queue, pending items can still be popped
+     * but every further push fails
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _closed = true;
+        }
+        _not_empty.notify_all();
+        _not_full.notify_all();
+    }
+
+    bool closed() const {
+        std::lock_guard<std::mutex> lock(_mtx);
+        return _closed;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(_mtx);
+        return _queue.size();
+    }
+
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    /***
+     * get the number of items discarded by the drop policy
+     * @return
+     */
+    uint64_t dropped() const {
+        std::lock_guard<std::mutex> lock(_mtx);
+        return _dropped;
+    }
+
+private:
+
+    mutable std::mutex _mtx;
+
+    std::condition_variable _not_empty;
+
+    std::condition_variable _not_full;
+
+    std::deque<T> _queue;
+
+    size_t _capacity = 1;
+
+    drop_policy_t _policy = BLOCK;
+
+    uint64_t _dropped = 0;
+
+    bool _closed = false;
+
+};
+
+#endif // __BOUNDEDQUEUE_HPP
@@ -11,11 +11,11 @@ public:
     Clock() = default;
 
     void start() {
-        _begin = std::chrono::system_clock::now();
+        _begin = std::chrono::steady_clock::now();
     }
 
     void stop() {
-        _end = std::chrono::system_clock::now();
+        _end = std::chrono::steady_clock::now();
     }
 
     double nanoseconds() const {
@@ -44,9 +44,9 @@ public:
 
 private:
 
-    std::chrono::system_clock::time_point _begin;
+    std::chrono::steady_clock::time_point _begin;
 
-    std::chrono::system_clock::time_point _end;
+    std::chrono::steady_clock::time_point _end;
 
 };
 
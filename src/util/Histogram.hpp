@@ -0,0 +1,164 @@
+#ifndef __HISTOGRAM_HPP
+#define __HISTOGRAM_HPP
+
+#include <atomic>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/***
+ * Lock-free log-linear histogram in the spirit of HdrHistogram.
+ * Values are sorted into buckets that are exact below 2^SUB_BITS and
+ * otherwise split every power of two into 2^SUB_BITS linear sub-buckets,
+ * which keeps the relative error of every reported value below 2^-SUB_BITS.
+ * Recording a value is a single relaxed atomic increment plus bookkeeping
+ * of count, sum and maximum, so it can be called from any thread at any rate.
+ */
+class Histogram {
+public:
+
+    // number of bits resolved linearly within each power of two
+    static constexpr unsigned SUB_BITS = 5;
+
+    // values are clamped to 2^MAX_BITS - 1
+    static constexpr unsigned MAX_BITS = 32;
+
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) << SUB_BITS;
+
+    /***
+     * copy of the histogram taken at one point in time
+     */
+    struct Snapshot {
+
+        uint64_t count = 0;
+
+        uint64_t sum = 0;
+
+        uint64_t max = 0;
+
+        std::vector<uint64_t> buckets;
+
+        /***
+         * get the value below which the given fraction of all values lies
+         * @param p fraction in [0, 1]
+         * @return
+         */
+        uint64_t percentile(double p) const {
+            if (count == 0) {
+                return 0;
+            }
+            const auto rank = static_cast<uint64_t>(p * double(count - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                seen += buckets[i];
+                if (seen >= rank) {
+                    const uint64_t value = Histogram::value(i);
+                    return value < max ? value : max;
+                }
+            }
+            return max;
+        }
+
+        double mean() const {
+            return count > 0 ? double(sum) / double(count) : 0.0;
+        }
+
+    };
+
+    Histogram() {
+        for (auto &bucket : _buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    Histogram(const Histogram &histogram) = delete;
+
+    Histogram& operator=(const Histogram &histogram) = delete;
+
+    /***
+     * add value to the histogram
+     * @param value
+     */
+    void record(uint64_t value) {
+        _buckets[index(value)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = _max.load(std::memory_order_relaxed);
+        while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+    }
+
+    /***
+     * copy the current state of the histogram
+     * @param reset if true, the histogram is emptied in the same step
+     * @return
+     */
+    Snapshot snapshot(bool reset=false) {
+        Snapshot snapshot;
+        snapshot.buckets.resize(BUCKETS);
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            snapshot.buckets[i] = reset ? _buckets[i].exchange(0, std::memory_order_relaxed)
+                                        : _buckets[i].load(std::memory_order_relaxed);
+            snapshot.count += snapshot.buckets[i];
+        }
+        snapshot.sum = reset ? _sum.exchange(0, std::memory_order_relaxed) : _sum.load(std::memory_order_relaxed);
+        snapshot.max = reset ? _max.exchange(0, std::memory_order_relaxed) : _max.load(std::memory_order_relaxed);
+        if (reset) {
+            _count.store(0, std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+    /***
+     * get the number of recorded values
+     * @return
+     */
+    uint64_t count() const {
+        return _count.load(std::memory_order_relaxed);
+    }
+
+    /***
+     * get the bucket a value is sorted into
+     * @param value
+     * @return
+     */
+    static size_t index(uint64_t value) {
+        if (value >= (UINT64_C(1) << MAX_BITS)) {
+            value = (UINT64_C(1) << MAX_BITS) - 1;
+        }
+        if (value < (UINT64_C(1) << SUB_BITS)) {
+            return (size_t) value;
+        }
+        const unsigned msb = 63 - __builtin_clzll(value);
+        const unsigned shift = msb - SUB_BITS;
+        const uint64_t top = value >> shift;
+        return ((size_t) (shift + 1) << SUB_BITS) + (size_t) (top - (UINT64_C(1) << SUB_BITS));
+    }
+
+    /***
+     * get the value that represents a bucket, the middle of its range
+     * @param index
+     * @return
+     */
+    static uint64_t value(size_t index) {
+        if (index < (size_t(1) << SUB_BITS)) {
+            return index;
+        }
+        const unsigned shift = (unsigned) (index >> SUB_BITS) - 1;
+        const uint64_t top = (index & ((size_t(1) << SUB_BITS) - 1)) + (UINT64_C(1) << SUB_BITS);
+        return (top << shift) + ((UINT64_C(1) << shift) >> 1);
+    }
+
+private:
+
+    std::array<std::atomic<uint64_t>, BUCKETS> _buckets;
+
+    std::atomic<uint64_t> _count { 0 };
+
+    std::atomic<uint64_t> _sum { 0 };
+
+    std::atomic<uint64_t> _max { 0 };
+
+};
+
+#endif // __HISTOGRAM_HPP
@@ -0,0 +1,155 @@
+#ifndef __MAILBOX_HPP
+#define __MAILBOX_HPP
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+/***
+ * Single-slot mailbox for exactly one producer and one consumer where
+ * the newest item always wins.
+ * It is implemented as a lock-free triple buffer: the producer owns one
+ * slot, the consumer owns another one and the third slot is exchanged
+ * atomically between them. A new item replaces an unread one, which
+ * is then counted as dropped.
+ * The mutex is only used to put an idle consumer to sleep, it is
+ * never held while items are handed over.
+ * @tparam T item type, must be movable
+ */
+template <typename T>
+class Mailbox {
+public:
+
+    Mailbox() = default;
+
+    Mailbox(const Mailbox &mailbox) = delete;
+
+    Mailbox& operator=(const Mailbox &mailbox) = delete;
+
+    /***
+     * publish item, replacing the previous one if it has not been read yet
+     * may only be called from the producer thread
+     * @param item
+     */
+    void write(T &&item) {
+        _slots[_back] = std::move(item);
+        const uint8_t prev = _state.exchange(_back | FRESH, std::memory_order_acq_rel);
+        _back = prev & INDEX;
+        if (prev & FRESH) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        _written.fetch_add(1, std::memory_order_relaxed);
+
+        // grab the lock once so a consumer that is about to wait cannot miss the wakeup
+        { std::lock_guard<std::mutex> lock(_mtx); }
+        _cv.notify_one();
+    }
+
+    /***
+     * take the newest item if there is one that has not been read yet
+     * may only be called from the consumer thread
+     * @param item
+     * @return true if an item has been taken
+     */
+    bool tryRead(T &item) {
+        if (!(_state.load(std::memory_order_acquire) & FRESH)) {
+            return false;
+        }
+        const uint8_t prev = _state.exchange(_front, std::memory_order_acq_rel);
+        _front = prev & INDEX;
+        item = std::move(_slots[_front]);
+        return true;
+    }
+
+    /***
+     * wait for a new item and take it
+     * may only be called from the consumer thread
+     * @param item
+     * @return false if the mailbox has been closed
+     */
+    bool read(T &item) {
+        while (!tryRead(item)) {
+            std::unique_lock<std::mutex> lock(_mtx);
+            _cv.wait(lock, [this]{
+                return _closed.load() || (_state.load(std::memory_order_acquire) & FRESH);
+            });
+            if (_closed) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /***
+     * wake up the consumer and make every further read() fail
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _closed = true;
+        }
+        _cv.notify_all();
+    }
+
+    /***
+     * re-open a closed mailbox, any unread item is discarded
+     */
+    void reset() {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _state.fetch_and(INDEX);
+        _closed = false;
+    }
+
+    bool closed() const {
+        return _closed;
+    }
+
+    /***
+     * get the number of items that have been written
+     * @return
+     */
+    uint64_t written() const {
+        return _written.load(std::memory_order_relaxed);
+    }
+
+    /***
+     * get the number of items that have been replaced before they were read
+     * @return
+     */
+    uint64_t dropped() const {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    enum : uint8_t {
+        INDEX = 0x03,
+        FRESH = 0x04
+    };
+
+    T _slots[3];
+
+    // index of the shared slot and whether it holds an unread item
+    std::atomic<uint8_t> _state { 1 };
+
+    // slot owned by the producer
+    uint8_t _back = 0;
+
+    // slot owned by the consumer
+    uint8_t _front = 2;
+
+    std::atomic<uint64_t> _written { 0 };
+
+    std::atomic<uint64_t> _dropped { 0 };
+
+    std::atomic_bool _closed { false };
+
+    std::mutex _mtx;
+
+    std::condition_variable _cv;
+
+};
+
+#endif // __MAILBOX_HPP
@@ -0,0 +1,105 @@
+#ifndef __MAPPEDFILE_HPP
+#define __MAPPEDFILE_HPP
+
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/***
+ * Read-only memory mapping of a whole file.
+ * The file content is served straight from the page cache, so a file that
+ * has been read before, e.g. by the last start of the program, is neither
+ * read from disk nor copied into a separate buffer.
+ */
+class MappedFile {
+public:
+
+    MappedFile() = default;
+
+    /***
+     * map file
+     * @param fname
+     */
+    explicit MappedFile(const std::string &fname) {
+        open(fname);
+    }
+
+    MappedFile(const MappedFile &file) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile& operator=(const MappedFile &file) = delete;
+
+    /***
+     * map file, throws std::runtime_error if it cannot be mapped
+     * @param fname
+     */
+    void open(const std::string &fname) {
+        close();
+        const int fd = ::open(fname.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open \'" + fname + '\'');
+        }
+
+        struct stat st = {};
+        if (::fstat(fd, &st) < 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot stat \'" + fname + '\'');
+        }
+
+        _size = (size_t) st.st_size;
+        if (_size > 0) {
+            void *data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                ::close(fd);
+                _size = 0;
+                throw std::runtime_error("cannot map \'" + fname + '\'');
+            }
+            // the whole file is parsed front to back
+            ::madvise(data, _size, MADV_SEQUENTIAL);
+            ::madvise(data, _size, MADV_WILLNEED);
+            _data = (const char *) data;
+        }
+        // the mapping stays valid without the descriptor
+        ::close(fd);
+        _opened = true;
+    }
+
+    void close() {
+        if (_data != nullptr) {
+            ::munmap((void *) _data, _size);
+        }
+        _data = nullptr;
+        _size = 0;
+        _opened = false;
+    }
+
+    bool isOpened() const {
+        return _opened;
+    }
+
+    const char* data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+private:
+
+    const char *_data = nullptr;
+
+    size_t _size = 0;
+
+    bool _opened = false;
+
+};
+
+#endif // __MAPPEDFILE_HPP
@@ -0,0 +1,42 @@
+#ifndef __SCOPEDTIMER_HPP
+#define __SCOPEDTIMER_HPP
+
+#include <chrono>
+#include <Histogram.hpp>
+
+/***
+ * Measures the time from its construction until it goes out of
+ * scope with the monotonic steady clock and records it in usec
+ */
+class ScopedTimer {
+public:
+
+    explicit ScopedTimer(Histogram &histogram) :
+            _histogram(histogram), _begin(std::chrono::steady_clock::now()) {}
+
+    ScopedTimer(const ScopedTimer &timer) = delete;
+
+    ~ScopedTimer() {
+        _histogram.record(elapsed());
+    }
+
+    ScopedTimer& operator=(const ScopedTimer &timer) = delete;
+
+    /***
+     * get the time since construction in usec
+     * @return
+     */
+    uint64_t elapsed() const {
+        return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - _begin).count();
+    }
+
+private:
+
+    Histogram &_histogram;
+
+    const std::chrono::steady_clock::time_point _begin;
+
+};
+
+#endif // __SCOPEDTIMER_HPP